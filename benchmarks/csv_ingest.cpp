@@ -0,0 +1,142 @@
+/*
+    Copyright 2009 Arizona State University
+
+    This file is part of Sirens.
+
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    Benchmark read_csv_columns against the getline/tokenise/string_to_double
+    loop it replaced, on a synthetic feature dump of the given size. Use a few
+    thousand megabytes to measure multi-GB dumps. The dump is written in the
+    same format FeatureSet produces and removed afterwards. Both loaders
+    checksum the bits of every value they read, so the checksums match only if
+    the parses are identical.
+    Usage: csv_ingest [megabytes=256] [path=csv_ingest.csv]
+*/
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <sys/time.h>
+using namespace std;
+
+#include "../source/string_support.h"
+using namespace Sirens;
+
+double seconds() {
+    timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1000000.0;
+}
+
+uint64_t checksum(const vector<vector<double> >& columns) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (int i = 0; i < columns.size(); i++) {
+        for (int j = 0; j < columns[i].size(); j++) {
+            uint64_t bits;
+            memcpy(&bits, &columns[i][j], sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ULL;
+        }
+    }
+
+    return hash;
+}
+
+// The loader segment_csv used before read_csv_columns.
+void read_tokenised(string path, vector<vector<double> >& values) {
+    ifstream csvfile(path.c_str());
+
+    while (csvfile.good()) {
+        string line;
+        vector<string> tokens;
+        getline(csvfile, line);
+        tokenise(line, tokens, ", ");
+
+        if (values.size() < 1) {
+            for (int i = 0; i < tokens.size(); i++)
+                values.push_back(vector<double>());
+        }
+
+        for (int i = 0; i < tokens.size() && i < values.size(); i++)
+            values[i].push_back(string_to_double(tokens[i]));
+    }
+}
+
+int main(int argc, char** argv) {
+    double megabytes = (argc > 1) ? atof(argv[1]) : 256;
+    string path = (argc > 2) ? argv[2] : "csv_ingest.csv";
+    int features = 6;
+
+    // Feature-like values at the stream's default precision: loudness in dB,
+    // spectral centroid in Bark, and ratios in [0, 1].
+    ofstream file(path.c_str());
+    unsigned int seed = 1;
+    long long frames = 0;
+    double bytes = 0;
+
+    while (bytes < megabytes * 1048576) {
+        for (int i = 0; i < features; i++) {
+            seed = seed * 1103515245 + 12345;
+            double noise = double(seed >> 16 & 0x7fff) / 32768.0;
+
+            if (i == 0)
+                file << -60 * noise;
+            else if (i == 1)
+                file << 24 * noise;
+            else
+                file << noise * noise;
+
+            file << (i < features - 1 ? "," : "\n");
+        }
+
+        frames++;
+
+        if (frames % 1000 == 0)
+            bytes = file.tellp();
+    }
+
+    bytes = file.tellp();
+    file.close();
+
+    cout << "loader,megabytes,frames,seconds,megabytes_per_second,checksum" << endl;
+
+    for (int loader = 0; loader < 2; loader++) {
+        vector<vector<double> > values;
+        double start = seconds();
+
+        if (loader == 0)
+            read_tokenised(path, values);
+        else
+            read_csv_columns(path, values);
+
+        double time = seconds() - start;
+
+        cout << (loader == 0 ? "tokenise" : "read_csv_columns") << "," <<
+            bytes / 1048576 << "," <<
+            (values.size() > 0 ? values[0].size() : 0) << "," <<
+            time << "," <<
+            bytes / 1048576 / time << "," <<
+            hex << checksum(values) << dec << endl;
+    }
+
+    remove(path.c_str());
+
+    return 0;
+}
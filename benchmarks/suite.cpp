@@ -0,0 +1,460 @@
+/*
+    Copyright 2009 Arizona State University
+
+    This file is part of Sirens.
+
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    Benchmark suite. Generates deterministic synthetic audio (harmonic tones,
+    noise bursts and chirps separated by silence) and reports, as JSON:
+        - FFT frames/sec.
+        - frames/sec of each feature on precomputed frames.
+        - Sound::extractFeatures real-time factor, threaded and fused.
+        - Segmenter::segment frames/sec versus feature count and beam width.
+        - SoundComparator::compare pairs/sec.
+    Usage: suite [seconds=20] [output.json]
+    Output goes to stdout if no path is given.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <unistd.h>
+#include <sys/time.h>
+using namespace std;
+
+#include "../source/Sirens.h"
+#include "../source/FFT.h"
+#include "../source/math_support.h"
+using namespace Sirens;
+
+const int SAMPLE_RATE = 44100;
+const double FRAME_LENGTH = 0.04;
+const double HOP_LENGTH = 0.02;
+
+double seconds() {
+    timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1000000.0;
+}
+
+/*------------------*
+ * Synthetic audio. *
+ *------------------*/
+
+// Alternates 1 s events (a harmonic tone, a noise burst, a chirp) with 0.5 s
+// of quiet noise.
+vector<double> synthesize(double duration, unsigned int seed) {
+    vector<double> samples(int(duration * SAMPLE_RATE));
+    double phase = 0;
+
+    for (int i = 0; i < samples.size(); i++) {
+        double t = double(i) / SAMPLE_RATE;
+        int event = int(t / 1.5);
+        double event_time = t - event * 1.5;
+
+        seed = seed * 1103515245 + 12345;
+        double noise = double(seed >> 16 & 0x7fff) / 16384.0 - 1.0;
+
+        double sample = 0.001 * noise;
+
+        if (event_time < 1.0) {
+            double envelope = sin(M_PI * event_time);
+            double f0 = 220.0 * (1 + (event % 4));
+
+            switch (event % 3) {
+                case 0:
+                    for (int h = 1; h <= 5; h++)
+                        sample += envelope * 0.3 / h * sin(2 * M_PI * f0 * h * t);
+                    break;
+                case 1:
+                    sample += envelope * 0.5 * noise;
+                    break;
+                case 2:
+                    phase += 2 * M_PI * (f0 + 2000 * event_time) / SAMPLE_RATE;
+                    sample += envelope * 0.5 * sin(phase);
+                    break;
+            }
+        }
+
+        samples[i] = sample;
+    }
+
+    return samples;
+}
+
+void write_int(FILE* file, unsigned int value, int bytes) {
+    for (int i = 0; i < bytes; i++)
+        fputc((value >> (8 * i)) & 0xff, file);
+}
+
+// Writes 16-bit mono PCM.
+void write_wav(string path, vector<double>& samples) {
+    FILE* file = fopen(path.c_str(), "wb");
+
+    fputs("RIFF", file);
+    write_int(file, 36 + samples.size() * 2, 4);
+    fputs("WAVEfmt ", file);
+    write_int(file, 16, 4);
+    write_int(file, 1, 2);
+    write_int(file, 1, 2);
+    write_int(file, SAMPLE_RATE, 4);
+    write_int(file, SAMPLE_RATE * 2, 4);
+    write_int(file, 2, 2);
+    write_int(file, 16, 2);
+    fputs("data", file);
+    write_int(file, samples.size() * 2, 4);
+
+    for (int i = 0; i < samples.size(); i++)
+        write_int(file, (unsigned short)(short)(maximum(-1.0, minimum(1.0, samples[i])) * 32767), 2);
+
+    fclose(file);
+}
+
+string temporary_wav(vector<double>& samples) {
+    char path[] = "/tmp/sirens_benchXXXXXX";
+    int descriptor = mkstemp(path);
+    close(descriptor);
+
+    write_wav(path, samples);
+
+    return path;
+}
+
+/*-----------*
+ * Features. *
+ *-----------*/
+
+// Holds one instance of each feature, with the segmentation parameters from
+// examples/segment.cpp where there are some.
+class Features {
+public:
+    Loudness loudness;
+    TemporalSparsity temporalSparsity;
+    SpectralSparsity spectralSparsity;
+    SpectralCentroid spectralCentroid;
+    TransientIndex transientIndex;
+    Harmonicity harmonicity;
+    FeatureSet featureSet;
+
+    Features(int frames, int spectrum_size) :
+        loudness(frames),
+        temporalSparsity(frames),
+        spectralSparsity(frames),
+        spectralCentroid(frames, spectrum_size, SAMPLE_RATE),
+        transientIndex(frames, spectrum_size, SAMPLE_RATE),
+        harmonicity(frames, spectrum_size, SAMPLE_RATE)
+    {
+        loudness.parameters()->alpha = 0.15;
+        loudness.parameters()->r = 0.0098;
+        loudness.parameters()->cStayOff = 0.0015;
+        loudness.parameters()->cTurnOn = 0.085;
+        loudness.parameters()->cTurnOff = 0.085;
+        loudness.parameters()->cNewSegment = 0.085;
+        loudness.parameters()->cStayOn = 0.05;
+        loudness.parameters()->pLagPlus = 0.75;
+        loudness.parameters()->pLagMinus = 0.75;
+
+        spectralCentroid.parameters()->alpha = 0.05;
+        spectralCentroid.parameters()->r = 0.00000196;
+        spectralCentroid.parameters()->cStayOff = 0.0000933506;
+        spectralCentroid.parameters()->cTurnOn = 0.85;
+        spectralCentroid.parameters()->cTurnOff = 0.85;
+        spectralCentroid.parameters()->cNewSegment = 0.85;
+        spectralCentroid.parameters()->cStayOn = 0.0025296018;
+        spectralCentroid.parameters()->pLagPlus = 0.75;
+        spectralCentroid.parameters()->pLagMinus = 0.075;
+
+        spectralSparsity.parameters()->alpha = 0.05;
+        spectralSparsity.parameters()->r = 0.0196;
+        spectralSparsity.parameters()->cStayOff = 0.001833506;
+        spectralSparsity.parameters()->cTurnOn = 0.85;
+        spectralSparsity.parameters()->cTurnOff = 0.85;
+        spectralSparsity.parameters()->cNewSegment = 0.85;
+        spectralSparsity.parameters()->cStayOn = 0.009296018;
+        spectralSparsity.parameters()->pLagPlus = 0.75;
+        spectralSparsity.parameters()->pLagMinus = 0.75;
+
+        featureSet.addSampleFeature(&loudness);
+        featureSet.addSampleFeature(&temporalSparsity);
+        featureSet.addSpectralFeature(&spectralSparsity);
+        featureSet.addSpectralFeature(&spectralCentroid);
+        featureSet.addSpectralFeature(&transientIndex);
+        featureSet.addSpectralFeature(&harmonicity);
+    }
+};
+
+// Calculates a feature in the calling thread.
+template <class T> class BenchFeature : public T {
+public:
+    BenchFeature(int frames) : T(frames) {}
+    BenchFeature(int frames, int spectrum_size) : T(frames, spectrum_size, SAMPLE_RATE) {}
+
+    void step(CircularArray* frame) {
+        this->input = frame;
+        this->prepareCalculation();
+    }
+};
+
+template <class T> double feature_fps(T& feature, vector<CircularArray*>& frames) {
+    double start = seconds();
+
+    for (int f = 0; f < frames.size(); f++)
+        feature.step(frames[f]);
+
+    return frames.size() / (seconds() - start);
+}
+
+int main(int argc, char** argv) {
+    double duration = (argc > 1) ? atof(argv[1]) : 20;
+
+    vector<double> audio = synthesize(duration, 1);
+    string audio_path = temporary_wav(audio);
+
+    Sound sound;
+    sound.setFrameLength(FRAME_LENGTH);
+    sound.setHopLength(HOP_LENGTH);
+    sound.open(audio_path);
+
+    int frame_count = sound.getFrameCount();
+    int samples_per_frame = sound.getSamplesPerFrame();
+    int samples_per_hop = sound.getSamplesPerHop();
+    int fft_size = sound.getFFTSize();
+    int spectrum_size = sound.getSpectrumSize();
+
+    stringstream json;
+    json << "{" << endl;
+    json << "  \"audio\": {\"seconds\": " << duration << ", \"sample_rate\": " <<
+        SAMPLE_RATE << ", \"frames\": " << frame_count << "}," << endl;
+
+    /*-----------------------------*
+     * FFT, computing the spectra. *
+     *-----------------------------*/
+
+    vector<CircularArray*> sample_frames;
+    vector<CircularArray*> spectrum_frames;
+
+    CircularArray windowed(samples_per_frame, fft_size);
+    double* window = create_hamming_window(samples_per_frame);
+    FFT fft(fft_size, windowed.getData());
+
+    double fft_time = 0;
+
+    for (int start = 0; start + samples_per_frame <= audio.size(); start += samples_per_hop) {
+        CircularArray* samples = new CircularArray(samples_per_frame);
+        CircularArray* spectrum = new CircularArray(spectrum_size);
+
+        for (int i = 0; i < samples_per_frame; i++) {
+            samples->addValue(audio[start + i]);
+            windowed.addValue(audio[start + i] * window[i]);
+        }
+
+        double fft_start = seconds();
+
+        fft.calculate();
+
+        for (int i = 0; i < fft.getOutputSize(); i++) {
+            double first = fft.getOutput()[i][0];
+            double second = fft.getOutput()[i][1];
+
+            spectrum->addValue(sqrt(first * first + second * second));
+        }
+
+        fft_time += seconds() - fft_start;
+
+        sample_frames.push_back(samples);
+        spectrum_frames.push_back(spectrum);
+    }
+
+    delete [] window;
+
+    int frames = sample_frames.size();
+
+    json << "  \"fft\": {\"fft_size\": " << fft_size << ", \"frames_per_second\": " <<
+        frames / fft_time << "}," << endl;
+
+    /*--------------------*
+     * Per-feature speed. *
+     *--------------------*/
+
+    BenchFeature<Loudness> loudness(frames);
+    BenchFeature<TemporalSparsity> temporal_sparsity(frames);
+    BenchFeature<SpectralSparsity> spectral_sparsity(frames);
+    BenchFeature<SpectralCentroid> spectral_centroid(frames, spectrum_size);
+    BenchFeature<TransientIndex> transient_index(frames, spectrum_size);
+    BenchFeature<Harmonicity> harmonicity(frames, spectrum_size);
+
+    json << "  \"features\": {" << endl;
+    json << "    \"Loudness\": " << feature_fps(loudness, sample_frames) << "," << endl;
+    json << "    \"TemporalSparsity\": " << feature_fps(temporal_sparsity, sample_frames) << "," << endl;
+    json << "    \"SpectralSparsity\": " << feature_fps(spectral_sparsity, spectrum_frames) << "," << endl;
+    json << "    \"SpectralCentroid\": " << feature_fps(spectral_centroid, spectrum_frames) << "," << endl;
+    json << "    \"TransientIndex\": " << feature_fps(transient_index, spectrum_frames) << "," << endl;
+    json << "    \"Harmonicity\": " << feature_fps(harmonicity, spectrum_frames) << endl;
+    json << "  }," << endl;
+
+    for (int f = 0; f < frames; f++) {
+        delete sample_frames[f];
+        delete spectrum_frames[f];
+    }
+
+    /*------------------------*
+     * End-to-end extraction. *
+     *------------------------*/
+
+    Features extracted(frame_count, spectrum_size);
+
+    json << "  \"extraction\": {" << endl;
+
+    for (int fused = 0; fused < 2; fused++) {
+        Features features(frame_count, spectrum_size);
+        features.featureSet.setFusedSpectralPass(fused);
+
+        double start = seconds();
+
+        sound.setFeatureSet(&features.featureSet);
+        sound.extractFeatures();
+
+        json << "    \"" << (fused ? "fused" : "threaded") << "_real_time_factor\": " <<
+            duration / (seconds() - start) << (fused ? "" : ",") << endl;
+    }
+
+    json << "  }," << endl;
+
+    sound.setFeatureSet(&extracted.featureSet);
+    sound.extractFeatures();
+    sound.close();
+
+    /*---------------*
+     * Segmentation. *
+     *---------------*/
+
+    Feature* segmentation_features[] = {
+        &extracted.loudness,
+        &extracted.spectralCentroid,
+        &extracted.spectralSparsity
+    };
+
+    int beam_widths[] = {-1, 3, 9, 27};
+
+    json << "  \"segmentation\": [" << endl;
+
+    string separator = "";
+
+    for (int feature_count = 1; feature_count <= 3; feature_count++) {
+        FeatureSet feature_set;
+
+        for (int i = 0; i < feature_count; i++)
+            feature_set.addSpectralFeature(segmentation_features[i]);
+
+        int states = int(pow(3.0, feature_count + 1));
+
+        for (int b = 0; b < 4; b++) {
+            if (beam_widths[b] >= states)
+                continue;
+
+            Segmenter segmenter(0.00000000001, 0.00000000001, beam_widths[b]);
+            segmenter.setFeatureSet(&feature_set);
+
+            double start = seconds();
+
+            segmenter.segment();
+
+            double elapsed = seconds() - start;
+
+            json << separator << "    {\"features\": " << feature_count << ", \"beams\": " <<
+                (beam_widths[b] < 0 ? states : beam_widths[b]) <<
+                ", \"frames_per_second\": " << frame_count / elapsed << "}";
+
+            separator = ",\n";
+        }
+    }
+
+    json << endl << "  ]," << endl;
+
+    /*------------*
+     * Retrieval. *
+     *------------*/
+
+    // Short sounds with different seeds and durations.
+    int sound_count = 6;
+    vector<Features*> sound_features(sound_count);
+    vector<SoundComparator*> comparators(sound_count);
+    vector<string> sound_paths(sound_count);
+
+    for (int i = 0; i < sound_count; i++) {
+        vector<double> clip = synthesize(1.5 + 0.5 * i, i + 2);
+        sound_paths[i] = temporary_wav(clip);
+
+        Sound clip_sound;
+        clip_sound.setFrameLength(FRAME_LENGTH);
+        clip_sound.setHopLength(HOP_LENGTH);
+        clip_sound.open(sound_paths[i]);
+
+        sound_features[i] = new Features(clip_sound.getFrameCount(), clip_sound.getSpectrumSize());
+
+        clip_sound.setFeatureSet(&sound_features[i]->featureSet);
+        clip_sound.extractFeatures();
+        clip_sound.close();
+
+        unlink(sound_paths[i].c_str());
+    }
+
+    double start = seconds();
+
+    for (int i = 0; i < sound_count; i++) {
+        comparators[i] = new SoundComparator(&sound_features[i]->featureSet);
+        comparators[i]->initialize();
+    }
+
+    double initialize_time = seconds() - start;
+
+    start = seconds();
+
+    int pairs = 0;
+
+    for (int i = 0; i < sound_count; i++) {
+        for (int j = 0; j < sound_count; j++) {
+            comparators[i]->compare(comparators[j]);
+            pairs ++;
+        }
+    }
+
+    double compare_time = seconds() - start;
+
+    json << "  \"retrieval\": {\"sounds\": " << sound_count <<
+        ", \"initializations_per_second\": " << sound_count / initialize_time <<
+        ", \"pairs_per_second\": " << pairs / compare_time << "}" << endl;
+    json << "}" << endl;
+
+    for (int i = 0; i < sound_count; i++) {
+        delete comparators[i];
+        delete sound_features[i];
+    }
+
+    unlink(audio_path.c_str());
+
+    if (argc > 2) {
+        ofstream output(argv[2]);
+        output << json.str();
+    } else
+        cout << json.str();
+
+    return 0;
+}
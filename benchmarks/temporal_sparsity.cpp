@@ -0,0 +1,147 @@
+/*
+    Copyright 2009 Arizona State University
+
+    This file is part of Sirens.
+
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    Benchmark TemporalSparsity's running window statistics against a full
+    rescan of the RMS window every frame, for window sizes of 10 to 10,000
+    frames. Also reports the largest difference between the two.
+    Usage: temporal_sparsity [frames=20000]
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <sys/time.h>
+using namespace std;
+
+#include "../source/Sirens.h"
+#include "../source/math_support.h"
+using namespace Sirens;
+
+// Exposes the protected input buffer so frames can be fed without a thread.
+class BenchTemporalSparsity : public TemporalSparsity {
+public:
+    BenchTemporalSparsity(int window_size) : TemporalSparsity(1, window_size) {}
+
+    void step(CircularArray* frame) {
+        input = frame;
+        performCalculation();
+    }
+};
+
+// The original O(window) implementation, kept as a reference.
+double rescan_temporal_sparsity(CircularArray* rms_window, double rms) {
+    rms_window->addValue(rms);
+
+    double max = 0;
+    double sum = 0;
+    double* rms_item = rms_window->getData();
+
+    for (int i = 0; i < rms_window->getSize(); i++) {
+        max = maximum(max, (*rms_item));
+        sum += (*rms_item);
+        rms_item ++;
+    }
+
+    if (!sum)
+        return 0;
+    else if (rms_window->getSize() >= rms_window->getMaxSize())
+        return max / sum;
+    else
+        return (
+            double(rms_window->getSize()) / double(rms_window->getMaxSize())
+        ) * max / sum;
+}
+
+double seconds() {
+    timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1000000.0;
+}
+
+int main(int argc, char** argv) {
+    int frames = (argc > 1) ? atoi(argv[1]) : 20000;
+    int frame_size = 882;
+
+    // Deterministic noise bursts with a slowly varying envelope.
+    vector<CircularArray*> inputs(frames);
+    unsigned int seed = 1;
+
+    for (int f = 0; f < frames; f++) {
+        double envelope = (f / 200) % 3 ? 0.5 + 0.5 * sin(f * 0.01) : 0;
+        inputs[f] = new CircularArray(frame_size);
+
+        for (int i = 0; i < frame_size; i++) {
+            seed = seed * 1103515245 + 12345;
+            inputs[f]->addValue(envelope * (double(seed >> 16 & 0x7fff) / 16384.0 - 1.0));
+        }
+    }
+
+    vector<double> rms(frames);
+
+    for (int f = 0; f < frames; f++)
+        rms[f] = signal_rms(inputs[f]);
+
+    int window_sizes[] = {10, 100, 1000, 10000};
+
+    cout << "window,frames,incremental_fps,rescan_fps,max_difference" << endl;
+
+    for (int w = 0; w < 4; w++) {
+        BenchTemporalSparsity incremental(window_sizes[w]);
+        CircularArray rms_window(window_sizes[w]);
+        vector<double> values(frames);
+        double max_difference = 0;
+
+        double start = seconds();
+
+        for (int f = 0; f < frames; f++) {
+            incremental.step(inputs[f]);
+            values[f] = incremental.getValue();
+        }
+
+        double incremental_time = seconds() - start;
+
+        start = seconds();
+
+        for (int f = 0; f < frames; f++) {
+            double value = rescan_temporal_sparsity(&rms_window, rms[f]);
+            max_difference = maximum(max_difference, fabs(value - values[f]));
+        }
+
+        double rescan_time = seconds() - start;
+
+        // The rescan reuses precomputed RMS, so add the incremental run's RMS
+        // cost back for a fair comparison.
+        start = seconds();
+
+        for (int f = 0; f < frames; f++)
+            rms[f] = signal_rms(inputs[f]);
+
+        rescan_time += seconds() - start;
+
+        cout << window_sizes[w] << "," << frames << "," <<
+            frames / incremental_time << "," <<
+            frames / rescan_time << "," <<
+            max_difference << endl;
+    }
+
+    for (int f = 0; f < frames; f++)
+        delete inputs[f];
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+    Copyright 2009 Arizona State University
+
+    This file is part of Sirens.
+
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    Convert feature trajectories between CSV (as written by FeatureSet::saveCSV)
+    and binary trajectory files (see TrajectoryFile.h).
+    Usage: convert_trajectories input output [sample_rate hop_size] [float32]
+
+    If input is a trajectory file, it is written to output as CSV. Otherwise
+    input is read as CSV and written to output as a trajectory file, recording
+    sample_rate (Hz) and hop_size (samples) if given. Add float32 to store
+    single-precision values.
+*/
+
+#include <iostream>
+#include <string>
+using namespace std;
+
+#include "../source/Sirens.h"
+#include "../source/string_support.h"
+using namespace Sirens;
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        cerr << "Usage: convert_trajectories input output [sample_rate hop_size] [float32]" << endl;
+        return 1;
+    } else {
+        try {
+            if (TrajectoryFile::isTrajectoryFile(argv[1])) {
+                TrajectoryFile trajectories;
+                trajectories.open(argv[1]);
+                trajectories.saveCSV(argv[2]);
+
+                cout << argv[1] << " -> " << argv[2] << " (CSV, " <<
+                    trajectories.getFeatureCount() << " features, " <<
+                    trajectories.getFrameCount() << " frames)." << endl;
+            } else {
+                double sample_rate = 0;
+                double hop_size = 0;
+                int value_size = 8;
+
+                if (argc > 4) {
+                    sample_rate = string_to_double(argv[3]);
+                    hop_size = string_to_double(argv[4]);
+                }
+
+                if (string(argv[argc - 1]) == "float32")
+                    value_size = 4;
+
+                TrajectoryFile::convertFromCSV(
+                    argv[1],
+                    argv[2],
+                    sample_rate,
+                    hop_size,
+                    value_size
+                );
+
+                cout << argv[1] << " -> " << argv[2] << " (trajectory file)." << endl;
+            }
+        } catch (exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -42,6 +42,7 @@ int main(int argc, char** argv) {
 		int frames = sound->getFrameCount() - 1;			// First frame of TransientIndex is junk, so don't want to record it.
 		int spectrum_size = sound->getSpectrumSize();
 		int sample_rate = sound->getSampleRate();
+		int samples_per_hop = sound->getSamplesPerHop();
 	
 		Loudness* loudness = new Loudness(frames);
 		TransientIndex* transient_index = new TransientIndex(frames, spectrum_size, sample_rate, 30, 15);
@@ -69,9 +70,14 @@ int main(int argc, char** argv) {
 		sound->extractFeatures();
 		sound->close();
 		
+		// Output ending in .traj is saved as a binary trajectory file.
 		string outfile = argc > 2 ? argv[2] : "features.csv";
 		cout << "Saving output to " << outfile << "." << endl;
-		feature_set->saveCSV(outfile);
+		
+		if (outfile.size() > 5 && outfile.substr(outfile.size() - 5) == ".traj")
+			feature_set->saveTrajectories(outfile, sample_rate, samples_per_hop);
+		else
+			feature_set->saveCSV(outfile);
 		
 		// Clean up.
 		delete sound;
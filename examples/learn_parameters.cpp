@@ -0,0 +1,165 @@
+/*
+    Copyright 2009 Arizona State University
+
+    This file is part of Sirens.
+
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    Learn segmentation parameters from feature trajectories (see
+    ParameterLearner.h), starting from a parameter file, and save them in the
+    same format.
+    Usage: learn_parameters parameters.csv output.csv features.csv [...]
+
+    parameters.csv and output.csv are parameter files as read by segment_csv.
+    Each features file is a recording, as a CSV file or binary trajectory file
+    (see segment_csv), with the same features in the same order. More than 3
+    features are segmented with the factorized decoder (see
+    Segmenter::setFactorized).
+*/
+
+#include <iostream>
+using namespace std;
+
+#include "../source/Sirens.h"
+#include "../source/string_support.h"
+using namespace Sirens;
+
+void progress_callback(int iteration, int iterations) {
+    cout << "\tIteration " << iteration << " of at most " << iterations << "." << endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        cerr << "Usage: learn_parameters parameters output features [...]" << endl;
+        return 1;
+    }
+
+    // Load feature values. One line per frame.
+    cout << "1: Loading features." << endl;
+
+    vector<FeatureSet*> feature_sets;
+    vector<Feature*> features;
+
+    for (int i = 3; i < argc; i++) {
+        vector<Feature*> recording_features;
+        vector<vector<double> > values;
+
+        if (TrajectoryFile::isTrajectoryFile(argv[i])) {
+            TrajectoryFile trajectories;
+            trajectories.open(argv[i]);
+            recording_features = trajectories.createFeatures();
+        } else if (!read_csv_columns(argv[i], values)) {
+            cerr << "Couldn't read " << argv[i] << "." << endl;
+            return 1;
+        }
+
+        for (int j = 0; j < values.size(); j++) {
+            Feature* feature = new Feature();
+            feature->getHistory()->addValues(&values[j][0], values[j].size());
+
+            recording_features.push_back(feature);
+        }
+
+        FeatureSet* feature_set = new FeatureSet();
+
+        for (int j = 0; j < recording_features.size(); j++) {
+            feature_set->addSampleFeature(recording_features[j]);
+            features.push_back(recording_features[j]);
+        }
+
+        feature_sets.push_back(feature_set);
+
+        cout << "\t" << argv[i] << ": " << recording_features.size() << " features, " <<
+            feature_set->getMinHistorySize() << " frames." << endl;
+    }
+
+    // Load initial segmentation parameters into the first recording's
+    // features. One line per feature.
+    cout << "2: Loading parameters from " << argv[1] << "." << endl;
+
+    vector<Feature*> first_features = feature_sets[0]->getFeatures();
+    vector<vector<double> > rows;
+    read_csv_rows(argv[1], rows);
+
+    int beams = 0;
+    double pon = 0;
+    double poff = 0;
+
+    for (int i = 0; i < rows.size(); i++) {
+        vector<double>& row = rows[i];
+
+        if (i == 0 && row.size() >= 3) {
+            pon = row[0];
+            poff = row[1];
+            beams = int(row[2]);
+        } else if (row.size() >= 9 && i - 1 < first_features.size()) {
+            SegmentationParameters* params = first_features[i - 1]->parameters();
+            params->alpha = row[0];
+            params->r = row[1];
+            params->cStayOff = row[2];
+            params->cTurnOn = row[3];
+            params->cTurnOff = row[4];
+            params->cNewSegment = row[5];
+            params->cStayOn = row[6];
+            params->pLagPlus = row[7];
+            params->pLagMinus = row[8];
+        }
+    }
+
+    // Learn.
+    cout << "3: Learning parameters." << endl;
+
+    ParameterLearner learner(pon, poff, beams);
+    learner.setFactorized(first_features.size() > 3);
+    learner.setProgressCallback(*progress_callback);
+
+    for (int i = 0; i < feature_sets.size(); i++)
+        learner.addRecording(feature_sets[i]);
+
+    learner.learn();
+
+    cout << "4: Saving parameters to " << argv[2] << "." << endl;
+
+    if (!learner.saveParameters(argv[2])) {
+        cerr << "Couldn't write " << argv[2] << "." << endl;
+        return 1;
+    }
+
+    cout << "\ton: " << learner.getPNew() << endl << "\toff: " << learner.getPOff() << endl;
+
+    for (int i = 0; i < first_features.size(); i++) {
+        SegmentationParameters* params = learner.getParameters(i);
+
+        cout << "\tFeature " << i << endl <<
+            "\t\talpha: " << params->alpha << endl <<
+            "\t\tr: " << params->r << endl <<
+            "\t\tstay off: " << params->cStayOff << endl <<
+            "\t\tturn on: " << params->cTurnOn << endl <<
+            "\t\tturn off: " << params->cTurnOff << endl <<
+            "\t\tnew segment: " << params->cNewSegment << endl <<
+            "\t\tstay on: " << params->cStayOn << endl <<
+            "\t\tlag+: " << params->pLagPlus << endl <<
+            "\t\tlag-: " << params->pLagMinus << endl;
+    }
+
+    for (int i = 0; i < features.size(); i++)
+        delete features[i];
+
+    for (int i = 0; i < feature_sets.size(); i++)
+        delete feature_sets[i];
+
+    return 0;
+}
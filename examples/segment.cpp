@@ -63,7 +63,7 @@ int main(int argc, char** argv) {
 			 *--------------------------------------*/
 			cout << "2. Initializing feature parameters." << endl;
 
-			Loudness loudness(sound.getFrameCount());
+			Loudness loudness;
 			loudness.parameters()->alpha = 0.15;
 			loudness.parameters()->r = 0.0098;
 			loudness.parameters()->cStayOff = 0.0015;
@@ -74,7 +74,7 @@ int main(int argc, char** argv) {
 			loudness.parameters()->pLagPlus = 0.75;
 			loudness.parameters()->pLagMinus = 0.75;
 
-			SpectralCentroid spectral_centroid(sound.getFrameCount(), sound.getSpectrumSize(), sound.getSampleRate());
+			SpectralCentroid spectral_centroid(0, sound.getSpectrumSize(), sound.getSampleRate());
 			spectral_centroid.parameters()->alpha = 0.05;
 			spectral_centroid.parameters()->r = 0.00000196;
 			spectral_centroid.parameters()->cStayOff = 0.0000933506;
@@ -85,7 +85,7 @@ int main(int argc, char** argv) {
 			spectral_centroid.parameters()->pLagPlus = 0.75;
 			spectral_centroid.parameters()->pLagMinus = 0.075;
 
-			SpectralSparsity spectral_sparsity(sound.getFrameCount());
+			SpectralSparsity spectral_sparsity;
 			spectral_sparsity.parameters()->alpha = 0.05;
 			spectral_sparsity.parameters()->r = 0.0196;
 			spectral_sparsity.parameters()->cStayOff = 0.001833506;
@@ -143,11 +143,7 @@ int main(int argc, char** argv) {
 					cout << "\tNo segments to save." << endl;
 				else {
 					cout << "\tSaving " << segments.size() << " segments." << endl;
-
-					for (int i = 0; i < segments.size(); i++) {
-						cout << "\t\tSaving segment " << i << "." << endl;
-						sound.saveSegment("segment" + double_to_string(i) + ".wav", segments[i][0], segments[i][1]);
-					}
+					sound.saveSegments(segments, "segment");
 				}
 			}
 
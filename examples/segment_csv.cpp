@@ -19,9 +19,12 @@
 
 /*
     Load a feature CSV file and segment it according to given parameters.
-    Usage: segmentcsv features.csv parameters.csv [samples_per_hop=882]
+    Usage: segmentcsv features.csv parameters.csv [samples_per_hop=882] [decimation=1]
+        [factorized=0]
 
-    features.csv contains 1 row for each frame, one column for each feature.
+    features.csv contains 1 row for each frame, one column for each feature. It
+    may also be a binary trajectory file (see TrajectoryFile.h), in which case
+    samples_per_hop defaults to the file's hop size.
     params.csv is formatted as follows:
         P(on), P(off)
         alpha_1,r_1,stayoff_1,turnon_1,turnoff_1,newsegment_1,stayon_1,lag+_1,lag-_1
@@ -29,12 +32,19 @@
         ...
 
     samples_per_hop is just for output. The last two columns are segment start
-    and end times in samples rather than feature frames.
+    and end times in samples rather than feature frames. 0 uses the default.
+
+    A decimation above 1 segments coarse-to-fine, decoding at full resolution
+    only around events found in the trajectory averaged over that many frames
+    (see Segmenter::setDecimation).
+
+    A nonzero factorized decodes each feature's modes separately from the
+    global mode, for feature sets too large for the joint state space (see
+    Segmenter::setFactorized).
 */
 
 #include <iostream>
 #include <string>
-#include <fstream>
 using namespace std;
 
 #include <sndfile.h>
@@ -50,13 +60,22 @@ void progress_callback(int frame, int frames) {
 
 int main(int argc, char** argv) {
     if (argc < 3) {
-        cerr << "Usage: segment_csv features parameters [samples_per_hop=882]" << endl;
+        cerr << "Usage: segment_csv features parameters [samples_per_hop=882] [decimation=1] [factorized=0]" << endl;
         return 1;
     } else {
         double samples_per_hop = 882;
+        bool default_hop = true;
+        int decimation = 1;
 
-        if (argc > 3)
+        if (argc > 3 && string_to_double(argv[3]) > 0) {
             samples_per_hop = string_to_double(argv[3]);
+            default_hop = false;
+        }
+
+        if (argc > 4)
+            decimation = int(string_to_double(argv[4]));
+
+        bool factorized = (argc > 5 && string_to_double(argv[5]) != 0);
 
         // Load feature values. One line per frame.
         cout << "1: Loading features from " << argv[1] << "." << endl;
@@ -64,77 +83,54 @@ int main(int argc, char** argv) {
         vector<Feature*> features;
         vector<vector<double> > values;
 
-        ifstream csvfile;
-        csvfile.open(argv[1]);
-        if (csvfile.is_open()) {
-            while (csvfile.good()) {
-                string line;
-                vector<string> tokens;
-                getline(csvfile, line);
-                tokenise(line, tokens, ", ");
-
-                if (values.size() < 1) {
-                    for (int i = 0; i < tokens.size(); i++)
-                        values.push_back(vector<double>());
-                }
-
-                for (int i = 0; i < tokens.size(); i++)
-                    values[i].push_back(string_to_double(tokens[i]));
-            }
-        }
+        if (TrajectoryFile::isTrajectoryFile(argv[1])) {
+            TrajectoryFile trajectories;
+            trajectories.open(argv[1]);
+            features = trajectories.createFeatures();
+
+            if (default_hop && trajectories.getHopSize() > 0)
+                samples_per_hop = trajectories.getHopSize();
+        } else
+            read_csv_columns(argv[1], values);
 
         for (int i = 0; i < values.size(); i++) {
             Feature* feature = new Feature();
-            feature->setMaxHistorySize(values[i].size());
-
-            for (int j = 0; j < values[i].size(); j++)
-                feature->addHistoryFrame(values[i][j]);
+            feature->getHistory()->addValues(&values[i][0], values[i].size());
 
             features.push_back(feature);
         }
 
-        csvfile.close();
-
         // Load segmentation parameters. One line per feature.
         cout << "2: Loading parameters from " << argv[2] << "." << endl;
 
-        ifstream paramsfile;
-        paramsfile.open(argv[2]);
-        int i = 0;
+        vector<vector<double> > rows;
+        read_csv_rows(argv[2], rows);
+
         int beams = 0;
         double pon = 0;
         double poff = 0;
 
-        if (paramsfile.is_open()) {
-            while (paramsfile.good()) {
-                string line;
-                vector<string> tokens;
-                getline(paramsfile, line);
-                tokenise(line, tokens, ", ");
-
-                if (i == 0 && tokens.size() >= 3) {
-                    pon = string_to_double(tokens[0]);
-                    poff = string_to_double(tokens[1]);
-                    beams = int(string_to_double(tokens[2]));
-                } else if (tokens.size() >= 9) {
-                    SegmentationParameters* params = features[i - 1]->parameters();
-                    params->alpha = string_to_double(tokens[0]);
-                    params->r = string_to_double(tokens[1]);
-                    params->cStayOff = string_to_double(tokens[2]);
-                    params->cTurnOn = string_to_double(tokens[3]);
-                    params->cTurnOff = string_to_double(tokens[4]);
-                    params->cNewSegment = string_to_double(tokens[5]);
-                    params->cStayOn = string_to_double(tokens[6]);
-                    params->pLagPlus = string_to_double(tokens[7]);
-                    params->pLagMinus = string_to_double(tokens[8]);
-                }
-
-                i++;
+        for (int i = 0; i < rows.size(); i++) {
+            vector<double>& row = rows[i];
+
+            if (i == 0 && row.size() >= 3) {
+                pon = row[0];
+                poff = row[1];
+                beams = int(row[2]);
+            } else if (row.size() >= 9 && i - 1 < features.size()) {
+                SegmentationParameters* params = features[i - 1]->parameters();
+                params->alpha = row[0];
+                params->r = row[1];
+                params->cStayOff = row[2];
+                params->cTurnOn = row[3];
+                params->cTurnOff = row[4];
+                params->cNewSegment = row[5];
+                params->cStayOn = row[6];
+                params->pLagPlus = row[7];
+                params->pLagMinus = row[8];
             }
         }
 
-        paramsfile.close();
-
         cout << "3. Summary." << endl;
         cout << "\ton: " << pon << endl << "\toff: " << poff << endl << "\tbeams: " << beams << endl << endl;
 
@@ -164,6 +160,8 @@ int main(int argc, char** argv) {
 
         Segmenter segmenter(pon, poff, beams);
         segmenter.setFeatureSet(&feature_set);
+        segmenter.setDecimation(decimation);
+        segmenter.setFactorized(factorized);
         segmenter.setProgressCallback(*progress_callback);
         segmenter.segment();
 
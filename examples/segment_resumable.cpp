@@ -0,0 +1,96 @@
+/*
+    Copyright 2009 Arizona State University
+
+    This file is part of Sirens.
+
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    Segment a sound file, checkpointing along the way so that the job can be
+    killed and run again without starting over (see SegmentationJob.h).
+    Usage: segment_resumable sound.wav checkpoint parameters.csv [interval]
+
+    Features are loudness, spectral centroid and spectral sparsity, in that
+    order. parameters.csv is a parameter file as read by segment_csv, for
+    those three features. A checkpoint is written every interval frames
+    (15000 by default) of extraction and of segmentation. Run again with the
+    same arguments after a failure to continue from the last checkpoint.
+
+    Prints one CSV line per segment (start frame, end frame).
+*/
+
+#include <iostream>
+using namespace std;
+
+#include "../source/Sirens.h"
+#include "../source/string_support.h"
+using namespace Sirens;
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        cerr << "Usage: segment_resumable sound checkpoint parameters [interval]" << endl;
+        return 1;
+    }
+
+    SegmentationConfiguration configuration;
+
+    if (!configuration.load(argv[3]) || configuration.parameters.size() != 3) {
+        cerr << "Couldn't read parameters for three features from " << argv[3] << "." << endl;
+        return 1;
+    }
+
+    try {
+        Sound sound;
+        sound.setFrameLength(0.04);
+        sound.setHopLength(0.02);
+        sound.open(argv[1]);
+
+        Loudness loudness;
+        SpectralCentroid spectral_centroid(0, sound.getSpectrumSize(), sound.getSampleRate());
+        SpectralSparsity spectral_sparsity;
+
+        FeatureSet feature_set;
+        feature_set.addSampleFeature(&loudness);
+        feature_set.addSpectralFeature(&spectral_centroid);
+        feature_set.addSpectralFeature(&spectral_sparsity);
+
+        sound.setFeatureSet(&feature_set);
+
+        Segmenter segmenter(configuration.pNew, configuration.pOff, configuration.beams);
+        segmenter.setFeatureSet(&feature_set);
+
+        for (int i = 0; i < 3; i++)
+            segmenter.setParameters(i, &configuration.parameters[i]);
+
+        SegmentationJob job(&sound, &segmenter);
+
+        if (argc > 4)
+            job.setCheckpoint(argv[2], int(string_to_double(argv[4])));
+        else
+            job.setCheckpoint(argv[2]);
+
+        job.run();
+
+        vector<vector<int> > segments = segmenter.getSegments();
+
+        for (int i = 0; i < segments.size(); i++)
+            cout << segments[i][0] << "," << segments[i][1] << endl;
+    } catch (exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -27,6 +27,23 @@ using namespace Sirens;
 
 #include <boost/numeric/ublas/io.hpp>
 
+// Whether each feature of the bank is calculated on the spectrum.
+const bool spectral[] = {false, true, true, false, true, true};
+
+// Build a bank of features, in the order of spectral.
+vector<Feature*> build_bank(int spectrum_size, int sample_rate) {
+	vector<Feature*> bank;
+
+	bank.push_back(new Loudness());
+	bank.push_back(new SpectralCentroid(0, spectrum_size, sample_rate));
+	bank.push_back(new SpectralSparsity());
+	bank.push_back(new TemporalSparsity());
+	bank.push_back(new TransientIndex(0, spectrum_size, sample_rate));
+	bank.push_back(new Harmonicity(0, spectrum_size, sample_rate));
+
+	return bank;
+}
+
 int main(int argc, char** argv) {
 	if (argc < 2) {
 		cerr << "Usage: similarity file1 file2 . . . fileN" << endl;
@@ -39,17 +56,19 @@ int main(int argc, char** argv) {
 			files.push_back(argv[i]);
 
 		/*
-			We have three of everything, because we have two files
-			and (unfortunately) features can't be shared.
+			Every file gets its own features, because the comparators
+			read their histories, but they needn't be built from
+			scratch: each file's features are cloned from the last
+			file's (see Feature::clone), which copies the tables they
+			built. A new bank is only built for the first file, or one
+			with a different spectrum size or sample rate.
 		*/
 
-		vector<Sound*> sounds(files.size());
-		vector<Loudness*> loudness(files.size());
-		vector<TemporalSparsity*> temporal_sparsity(files.size());
-		vector<SpectralSparsity*> spectral_sparsity(files.size());
-		vector<SpectralCentroid*> spectral_centroid(files.size());
-		vector<TransientIndex*> transient_index(files.size());
-		vector<Harmonicity*> harmonicity(files.size());
+		int bank_file = -1;
+		int bank_spectrum_size = -1;
+		int bank_sample_rate = -1;
+
+		vector<vector<Feature*> > features(files.size());
 		vector<FeatureSet*> feature_sets(files.size());
 		vector<SoundComparator*> comparators(files.size());
 
@@ -64,46 +83,32 @@ int main(int argc, char** argv) {
 			// Initialize the sound file.
 			sound->open(files[i]);
 
-			/*
-				The first frame of TransientIndex is junk, so
-				record everything except the first frame.
-			*/
-
-			int frames = sound->getFrameCount() - 1;
 			int spectrum_size = sound->getSpectrumSize();
 			int sample_rate = sound->getSampleRate();
 
-			// Initialize the features.
-			loudness[i] = new Loudness(frames);
-			temporal_sparsity[i] = new TemporalSparsity(frames);
-			spectral_sparsity[i] = new SpectralSparsity(frames);
-
-			transient_index[i] = new TransientIndex(
-				frames,
-				spectrum_size,
-				sample_rate
-			);
-
-			spectral_centroid[i] = new SpectralCentroid(
-				frames,
-				spectrum_size,
-				sample_rate
-			);
-
-			harmonicity[i] = new Harmonicity(
-				frames,
-				spectrum_size,
-				sample_rate
-			);
+			if (
+				bank_file >= 0 &&
+				spectrum_size == bank_spectrum_size &&
+				sample_rate == bank_sample_rate
+			) {
+				for (int j = 0; j < features[bank_file].size(); j++)
+					features[i].push_back(features[bank_file][j]->clone());
+			} else
+				features[i] = build_bank(spectrum_size, sample_rate);
+
+			bank_file = i;
+			bank_spectrum_size = spectrum_size;
+			bank_sample_rate = sample_rate;
 
 			// Initialize the feature set.
 			feature_sets[i] = new FeatureSet();
-			feature_sets[i]->addSampleFeature(loudness[i]);
-			feature_sets[i]->addSpectralFeature(spectral_centroid[i]);
-			feature_sets[i]->addSpectralFeature(spectral_sparsity[i]);
-			feature_sets[i]->addSampleFeature(temporal_sparsity[i]);
-			feature_sets[i]->addSpectralFeature(transient_index[i]);
-			feature_sets[i]->addSpectralFeature(harmonicity[i]);
+
+			for (int j = 0; j < features[i].size(); j++) {
+				if (spectral[j])
+					feature_sets[i]->addSpectralFeature(features[i][j]);
+				else
+					feature_sets[i]->addSampleFeature(features[i][j]);
+			}
 
 			// Extract features.
 			sound->setFeatureSet(feature_sets[i]);
@@ -138,11 +143,9 @@ int main(int argc, char** argv) {
 		for (int i = 0; i < files.size(); i++) {
 			delete comparators[i];
 			delete feature_sets[i];
-			delete loudness[i];
-			delete spectral_sparsity[i];
-			delete spectral_centroid[i];
-			delete transient_index[i];
-			delete harmonicity[i];
+
+			for (int j = 0; j < features[i].size(); j++)
+				delete features[i][j];
 		}
 
 		return 0;
@@ -0,0 +1,124 @@
+/*
+    Copyright 2009 Arizona State University
+
+    This file is part of Sirens.
+
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    Segment a feature file with many parameter files and score each against
+    reference boundaries (see SegmentationSweep.h).
+    Usage: sweep_segmentation features.csv reference.csv tolerance
+        parameters.csv [...]
+
+    features.csv is a CSV or binary trajectory file, as for segment_csv, and
+    each parameters.csv a parameter file as read by segment_csv. Every value in
+    reference.csv is a reference boundary, in frames, so it may have a boundary
+    per line or a segment's start and end. tolerance is in frames.
+
+    Prints one CSV line per parameter file (path, segments, matched boundaries,
+    precision, recall, F, seconds), then the best parameter file by F.
+*/
+
+#include <iostream>
+using namespace std;
+
+#include "../source/Sirens.h"
+#include "../source/string_support.h"
+using namespace Sirens;
+
+int main(int argc, char** argv) {
+    if (argc < 5) {
+        cerr << "Usage: sweep_segmentation features reference tolerance parameters [...]" << endl;
+        return 1;
+    }
+
+    // Load feature values, once for every configuration.
+    vector<Feature*> features;
+    vector<vector<double> > values;
+
+    if (TrajectoryFile::isTrajectoryFile(argv[1])) {
+        TrajectoryFile trajectories;
+        trajectories.open(argv[1]);
+        features = trajectories.createFeatures();
+    } else if (!read_csv_columns(argv[1], values)) {
+        cerr << "Couldn't read " << argv[1] << "." << endl;
+        return 1;
+    }
+
+    for (int i = 0; i < values.size(); i++) {
+        Feature* feature = new Feature();
+        feature->getHistory()->addValues(&values[i][0], values[i].size());
+
+        features.push_back(feature);
+    }
+
+    FeatureSet feature_set;
+
+    for (int i = 0; i < features.size(); i++)
+        feature_set.addSampleFeature(features[i]);
+
+    // Reference boundaries.
+    vector<vector<double> > rows;
+
+    if (!read_csv_rows(argv[2], rows)) {
+        cerr << "Couldn't read " << argv[2] << "." << endl;
+        return 1;
+    }
+
+    vector<int> boundaries;
+
+    for (int i = 0; i < rows.size(); i++) {
+        for (int j = 0; j < rows[i].size(); j++)
+            boundaries.push_back(int(rows[i][j]));
+    }
+
+    SegmentationSweep sweep(&feature_set);
+    sweep.setReferenceBoundaries(boundaries);
+    sweep.setTolerance(int(string_to_double(argv[3])));
+
+    // Configurations.
+    vector<string> paths;
+
+    for (int i = 4; i < argc; i++) {
+        SegmentationConfiguration configuration;
+
+        if (configuration.load(argv[i])) {
+            sweep.addConfiguration(configuration);
+            paths.push_back(argv[i]);
+        } else
+            cerr << "Couldn't read " << argv[i] << "; skipping it." << endl;
+    }
+
+    sweep.run();
+
+    for (int i = 0; i < sweep.getConfigurationCount(); i++) {
+        SegmentationScore* score = sweep.getScore(i);
+
+        cout << paths[i] << "," << score->segments.size() << "," <<
+            score->matched << "," << score->precision << "," <<
+            score->recall << "," << score->f << "," << score->seconds << endl;
+    }
+
+    int best = sweep.getBestConfiguration();
+
+    if (best >= 0)
+        cout << "Best: " << paths[best] << " (F " << sweep.getScore(best)->f << ")" << endl;
+
+    for (int i = 0; i < features.size(); i++)
+        delete features[i];
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Arena.h"
+
+namespace Sirens {
+    const size_t ARENA_ALIGNMENT = 16;
+    
+    Arena::Arena(size_t block_size) {
+        blockSize = block_size;
+        bytesAllocated = 0;
+        
+        pthread_mutex_init(&mutex, NULL);
+    }
+    
+    Arena::~Arena() {
+        for (unsigned int i = 0; i < blocks.size(); i++)
+            delete [] blocks[i].data;
+        
+        pthread_mutex_destroy(&mutex);
+    }
+    
+    void Arena::addBlock(size_t size) {
+        Block block;
+        block.data = new char[size];
+        block.size = size;
+        block.used = 0;
+        
+        blocks.push_back(block);
+    }
+    
+    void* Arena::allocate(size_t bytes) {
+        bytes = (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+        
+        pthread_mutex_lock(&mutex);
+        
+        // Only the newest block is filled; older ones are full enough.
+        if (blocks.empty() || blocks.back().size - blocks.back().used < bytes)
+            addBlock(bytes > blockSize ? bytes : blockSize);
+        
+        Block& block = blocks.back();
+        void* memory = block.data + block.used;
+        
+        block.used += bytes;
+        bytesAllocated += bytes;
+        
+        pthread_mutex_unlock(&mutex);
+        
+        return memory;
+    }
+    
+    void Arena::reset() {
+        pthread_mutex_lock(&mutex);
+        
+        if (blocks.size() > 1) {
+            size_t capacity = 0;
+            
+            for (unsigned int i = 0; i < blocks.size(); i++) {
+                capacity += blocks[i].size;
+                delete [] blocks[i].data;
+            }
+            
+            blocks.clear();
+            addBlock(capacity);
+        } else if (blocks.size() == 1)
+            blocks[0].used = 0;
+        
+        bytesAllocated = 0;
+        
+        pthread_mutex_unlock(&mutex);
+    }
+    
+    size_t Arena::getBytesAllocated() {
+        return bytesAllocated;
+    }
+    
+    size_t Arena::getCapacity() {
+        size_t capacity = 0;
+        
+        for (unsigned int i = 0; i < blocks.size(); i++)
+            capacity += blocks[i].size;
+        
+        return capacity;
+    }
+}
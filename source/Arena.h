@@ -0,0 +1,83 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_ARENA_H
+#define SIRENS_ARENA_H
+
+#include <cstddef>
+#include <pthread.h>
+#include <vector>
+using namespace std;
+
+/*
+    Arena - a bump allocator for memory that lives exactly as long as the
+        processing of one file: feature histories and per-feature buffers
+        (see Feature::setArena). Nothing is freed individually; reset()
+        releases everything at once.
+    
+    On reset, the arena's blocks are merged into a single block of their
+    combined size and kept, so a long-running worker that processes one file
+    after another stops allocating from the heap once it has seen its
+    largest file.
+    
+    allocate() is thread-safe, since features initialize on their own
+    threads. Memory is aligned to 16 bytes and is not initialized; only
+    plain data (numbers and structs of numbers) should be stored in it.
+*/
+
+namespace Sirens {
+    class Arena {
+    private:
+        struct Block {
+            char* data;
+            size_t size, used;
+        };
+        
+        vector<Block> blocks;
+        size_t blockSize;
+        size_t bytesAllocated;
+        
+        pthread_mutex_t mutex;
+        
+        void addBlock(size_t size);
+        
+        // Not copyable.
+        Arena(const Arena& other);
+        Arena& operator=(const Arena& other);
+        
+    public:
+        Arena(size_t block_size = 1 << 20);
+        ~Arena();
+        
+        void* allocate(size_t bytes);
+        
+        template <class T> T* allocate(int count) {
+            return (T*)allocate(sizeof(T) * count);
+        }
+        
+        // Releases everything allocated since the last reset.
+        void reset();
+        
+        // Bytes handed out since the last reset, and bytes held in blocks.
+        size_t getBytesAllocated();
+        size_t getCapacity();
+    };
+}
+
+#endif
@@ -0,0 +1,244 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+using namespace std;
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Checkpoint.h"
+
+namespace Sirens {
+    static const char checkpoint_magic[8] = {'S', 'I', 'R', 'E', 'N', 'S', 'C', 'P'};
+    static const uint32_t checkpoint_version = 2;
+    static const int header_size = 24;
+
+    Checkpoint::Checkpoint() {
+        position = 0;
+    }
+
+    /*----------*
+     * Writing. *
+     *----------*/
+
+    void Checkpoint::write(const void* values, size_t bytes) {
+        const char* first = (const char*)values;
+
+        state.insert(state.end(), first, first + bytes);
+    }
+
+    void Checkpoint::writeInt(int value) {
+        write(&value, sizeof(int));
+    }
+
+    void Checkpoint::writeLong(long value) {
+        int64_t stored = value;
+
+        write(&stored, sizeof(int64_t));
+    }
+
+    void Checkpoint::writeDouble(double value) {
+        write(&value, sizeof(double));
+    }
+
+    void Checkpoint::writeString(string value) {
+        writeInt(value.size());
+        write(value.data(), value.size());
+    }
+
+    void Checkpoint::writeDoubles(const double* values, int count) {
+        write(values, count * sizeof(double));
+    }
+
+    void Checkpoint::writeInts(const int* values, int count) {
+        write(values, count * sizeof(int));
+    }
+
+    /*----------*
+     * Reading. *
+     *----------*/
+
+    void Checkpoint::read(void* values, size_t bytes) {
+        if (bytes > state.size() - position)
+            throw CheckpointException();
+
+        if (bytes > 0)
+            memcpy(values, &state[position], bytes);
+
+        position += bytes;
+    }
+
+    int Checkpoint::readInt() {
+        int value;
+        read(&value, sizeof(int));
+
+        return value;
+    }
+
+    long Checkpoint::readLong() {
+        int64_t value;
+        read(&value, sizeof(int64_t));
+
+        return value;
+    }
+
+    double Checkpoint::readDouble() {
+        double value;
+        read(&value, sizeof(double));
+
+        return value;
+    }
+
+    string Checkpoint::readString() {
+        int size = readInt();
+
+        if (size < 0 || size > state.size() - position)
+            throw CheckpointException();
+
+        string value(&state[0] + position, size);
+        position += size;
+
+        return value;
+    }
+
+    void Checkpoint::readDoubles(double* values, int count) {
+        if (count < 0)
+            throw CheckpointException();
+
+        read(values, count * sizeof(double));
+    }
+
+    void Checkpoint::readInts(int* values, int count) {
+        if (count < 0)
+            throw CheckpointException();
+
+        read(values, count * sizeof(int));
+    }
+
+    void Checkpoint::expectInt(int expected) {
+        if (readInt() != expected)
+            throw CheckpointException();
+    }
+
+    void Checkpoint::expectString(string expected) {
+        if (readString() != expected)
+            throw CheckpointException();
+    }
+
+    void Checkpoint::clear() {
+        state.clear();
+        position = 0;
+    }
+
+    /*--------*
+     * Files. *
+     *--------*/
+
+    void Checkpoint::save(string path) {
+        string temporary_path = path + ".tmp";
+
+        {
+            ofstream file(temporary_path.c_str(), ios::out | ios::binary | ios::trunc);
+
+            if (!file.is_open())
+                throw CheckpointException();
+
+            char header[header_size];
+            memset(header, 0, header_size);
+
+            uint32_t version = checkpoint_version;
+            uint64_t size = state.size();
+
+            memcpy(header, checkpoint_magic, 8);
+            memcpy(header + 8, &version, 4);
+            memcpy(header + 16, &size, 8);
+
+            file.write(header, header_size);
+
+            if (!state.empty())
+                file.write(&state[0], state.size());
+
+            file.flush();
+
+            if (!file.good())
+                throw CheckpointException();
+        }
+
+        // Make sure the data is on disk before the rename, or a crash could
+        // leave an empty file in place of the previous checkpoint.
+        int descriptor = ::open(temporary_path.c_str(), O_WRONLY);
+
+        if (descriptor < 0)
+            throw CheckpointException();
+
+        int synced = fsync(descriptor);
+        ::close(descriptor);
+
+        if (synced != 0)
+            throw CheckpointException();
+
+        if (rename(temporary_path.c_str(), path.c_str()) != 0)
+            throw CheckpointException();
+    }
+
+    void Checkpoint::load(string path) {
+        ifstream file(path.c_str(), ios::in | ios::binary | ios::ate);
+
+        if (!file.is_open())
+            throw CheckpointException();
+
+        uint64_t file_size = file.tellg();
+        file.seekg(0);
+
+        char header[header_size];
+        file.read(header, header_size);
+
+        uint32_t version;
+        uint64_t size;
+
+        memcpy(&version, header + 8, 4);
+        memcpy(&size, header + 16, 8);
+
+        if (
+            !file.good() ||
+            memcmp(header, checkpoint_magic, 8) != 0 ||
+            version != checkpoint_version ||
+            size > file_size - header_size
+        )
+            throw CheckpointException();
+
+        clear();
+        state.resize(size);
+
+        if (size > 0 && uint64_t(file.read(&state[0], size).gcount()) != size) {
+            clear();
+            throw CheckpointException();
+        }
+    }
+
+    bool Checkpoint::exists(string path) {
+        ifstream file(path.c_str(), ios::in | ios::binary);
+
+        return file.is_open();
+    }
+}
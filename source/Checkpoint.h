@@ -0,0 +1,98 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_CHECKPOINT_H
+#define SIRENS_CHECKPOINT_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "Exceptions.h"
+
+/*
+    Checkpoint - a snapshot of a running extraction and segmentation, so that
+        long batch jobs can pick up where they left off after a failure (see
+        SegmentationJob). Components write their state in order (see
+        Sound::saveState, FeatureSet::saveState and Segmenter::saveState) and
+        read it back in the same order into objects configured the same way.
+        Values are written as they are in memory, so restoring continues bit
+        for bit, but only on the same platform.
+
+    Layout (little-endian):
+        Header, 24 bytes.
+            char[8]   magic, "SIRENSCP"
+            uint32    version (2)
+            uint32    reserved
+            uint64    state size
+        State, state size bytes.
+
+    save writes to a temporary file next to path, syncs it to disk and renames
+    it over path, so a job or machine that dies while saving leaves the
+    previous checkpoint in place.
+*/
+
+namespace Sirens {
+    class Checkpoint {
+    private:
+        vector<char> state;
+
+        // Offset of the next value read.
+        size_t position;
+
+    public:
+        Checkpoint();
+
+        // Writing, appending to the state.
+        void write(const void* values, size_t bytes);
+        void writeInt(int value);
+        void writeLong(long value);
+        void writeDouble(double value);
+        void writeString(string value);
+        void writeDoubles(const double* values, int count);
+        void writeInts(const int* values, int count);
+
+        // Reading, from the start of the state. Reading past its end throws
+        // CheckpointException.
+        void read(void* values, size_t bytes);
+        int readInt();
+        long readLong();
+        double readDouble();
+        string readString();
+        void readDoubles(double* values, int count);
+        void readInts(int* values, int count);
+
+        // Reads a value and throws CheckpointException if it isn't expected,
+        // for what must match between the saved and restored objects.
+        void expectInt(int expected);
+        void expectString(string expected);
+
+        // Empties the state.
+        void clear();
+
+        // Files. load throws CheckpointException if path can't be read or
+        // isn't a checkpoint, and save if it can't be written.
+        void save(string path);
+        void load(string path);
+
+        static bool exists(string path);
+    };
+}
+
+#endif
@@ -23,23 +23,28 @@
 #include "string_support.h"
 
 namespace Sirens {
-    CircularArray::CircularArray(int max_size, int allocated_size) {
+    CircularArray::CircularArray(int max_size, int allocated_size, Arena* arena_in) {
         start = 0;
         size = 0;
         index = 0;
         maxSize = max_size;
+        arena = arena_in;
 
         if (allocated_size == -1)
             allocated_size = maxSize;
 
-        data = new double[allocated_size];
+        if (arena)
+            data = arena->allocate<double>(allocated_size);
+        else
+            data = new double[allocated_size];
 
         for (int i = 0; i < allocated_size; i++)
             data[i] = 0;
     }
 
     CircularArray::~CircularArray() {
-        delete [] data;
+        if (!arena)
+            delete [] data;
     }
 
     void CircularArray::addValue(double value) {
@@ -53,6 +58,12 @@ namespace Sirens {
         index = (index + 1) % maxSize;
     }
 
+    void CircularArray::clear() {
+        start = 0;
+        size = 0;
+        index = 0;
+    }
+
     int CircularArray::getSize() {
         return size;
     }
@@ -94,4 +105,25 @@ namespace Sirens {
 
         return history_string;
     }
+
+    void CircularArray::saveState(Checkpoint* checkpoint) {
+        checkpoint->writeInt(maxSize);
+        checkpoint->writeInt(size);
+        checkpoint->writeInt(start);
+        checkpoint->writeInt(index);
+        checkpoint->writeDoubles(data, maxSize);
+    }
+
+    void CircularArray::loadState(Checkpoint* checkpoint) {
+        checkpoint->expectInt(maxSize);
+
+        size = checkpoint->readInt();
+        start = checkpoint->readInt();
+        index = checkpoint->readInt();
+
+        if (size < 0 || size > maxSize || start < 0 || start >= maxSize || index < 0 || index >= maxSize)
+            throw CheckpointException();
+
+        checkpoint->readDoubles(data, maxSize);
+    }
 }
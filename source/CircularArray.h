@@ -25,6 +25,9 @@ using namespace std;
 
 #include <pthread.h>
 
+#include "Arena.h"
+#include "Checkpoint.h"
+
 // Circular array allows values to be added and simply replace older values if
 // the maximum size is reached.
 namespace Sirens {
@@ -47,11 +50,17 @@ namespace Sirens {
         // Pointer to the last element of the array.
         int index;
 
+        // Arena the data was allocated from, if any.
+        Arena* arena;
+
     public:
-        CircularArray(int max_size = 1, int allocated_size = -1);
+        CircularArray(int max_size = 1, int allocated_size = -1, Arena* arena_in = NULL);
         ~CircularArray();
 
         void addValue(double value);
+        
+        // Empties the array without freeing it.
+        void clear();
 
         int getSize();
         int getMaxSize();
@@ -67,6 +76,11 @@ namespace Sirens {
         }
 
         string toString();
+
+        // Checkpointing (see Checkpoint). loadState throws
+        // CheckpointException if the maximum sizes differ.
+        void saveState(Checkpoint* checkpoint);
+        void loadState(Checkpoint* checkpoint);
     };
 }
 
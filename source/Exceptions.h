@@ -55,6 +55,24 @@ class UnsupportedEncodingException : public IOException {
     }
 };
 
+class TrajectoryFileException : public IOException {
+    virtual const char* what() const throw() {
+        return "Unreadable or malformed trajectory file.";
+    }
+};
+
+class CheckpointException : public IOException {
+    virtual const char* what() const throw() {
+        return "Unreadable, malformed or mismatched checkpoint.";
+    }
+};
+
+class SegmentExportException : public IOException {
+    virtual const char* what() const throw() {
+        return "Error reading sound file or writing segment file.";
+    }
+};
+
 class SoundNotLoadedException : public AnalysisException {
     virtual const char* what() const throw() {
         return "Sound file not loaded.";
@@ -19,6 +19,8 @@
 
 #include "FFT.h"
 
+#include "Instrumentation.h"
+
 namespace Sirens {
     FFT::FFT(int fft_size, double* input) {
         fftSize = fft_size;
@@ -41,6 +43,8 @@ namespace Sirens {
     }
 
     void FFT::calculate() {
+        SIRENS_TIMER("extract:fft");
+        
         fftw_execute(plan);
     }
 
@@ -17,21 +17,84 @@
     along with Sirens. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <vector>
+using namespace std;
+
 #include "Feature.h"
 
 #include "math_support.h"
+#include "Instrumentation.h"
 
 namespace Sirens {
     Feature::Feature(int history_size) {
-        history = new CircularArray(history_size);
-        segmentationParameters = new SegmentationParameters();
+        arena = NULL;
+        history = new FeatureHistory(history_size);
         max = 1.0;
         min = 0.0;
+        
+        initialized = false;
+        timerName = NULL;
+    }
+
+    Feature::Feature(const Feature& other) {
+        arena = other.arena;
+        history = new FeatureHistory(other.history->getBound(), arena);
+        segmentationParameters = other.segmentationParameters;
+        max = other.max;
+        min = other.min;
+        
+        input = NULL;
+        value = 0;
+        initialized = other.initialized;
+        timerName = NULL;
     }
 
     Feature::~Feature() {
         delete history;
-        delete segmentationParameters;
+    }
+
+    /*------------------*
+     * Per-file memory. *
+     *------------------*/
+
+    void Feature::setArena(Arena* arena_in) {
+        // Buffers must be freed the same way they were allocated.
+        freeMemory();
+
+        arena = arena_in;
+        initialized = false;
+
+        int history_size = history->getBound();
+        delete history;
+        history = new FeatureHistory(history_size, arena);
+        
+        reset();
+    }
+
+    Arena* Feature::getArena() {
+        return arena;
+    }
+
+    const char* Feature::getTimerName() {
+        if (timerName == NULL)
+            timerName = Instrumentation::intern(string("feature:") + toString());
+
+        return timerName;
+    }
+
+    /*--------*
+     * Reuse. *
+     *--------*/
+
+    void Feature::reset() {
+        history->clear();
+        value = 0;
+
+        resetState();
+    }
+
+    Feature* Feature::clone() {
+        return new Feature(*this);
     }
 
     /*--------------*
@@ -44,19 +107,73 @@ namespace Sirens {
         thread.start(run_feature, (void*)this);
     }
 
-    void Feature::prepareCalculation() {
+    void Feature::ensureInitialized() {
         if (!initialized) {
             freeMemory();
             initialize();
 
             initialized = true;
         }
+    }
+
+    void Feature::calculateSynchronously(CircularArray* input_in) {
+        input = input_in;
+
+        prepareCalculation();
+    }
+
+    void Feature::prepareCalculation() {
+        SIRENS_TIMER(getTimerName());
+
+        ensureInitialized();
 
         performCalculation();
+        finishCalculation();
+    }
+
+    void Feature::finishCalculation() {
         value = lerp(value, min, max);
         history->addValue(value);
     }
 
+    bool Feature::requestStatistics(SpectralStatistics* statistics) {
+        ensureInitialized();
+
+        return configureStatistics(statistics);
+    }
+
+    void Feature::calculateFused(CircularArray* input_in, SpectralStatistics* statistics) {
+        SIRENS_TIMER(getTimerName());
+
+        input = input_in;
+
+        ensureInitialized();
+
+        if (!performFusedCalculation(statistics))
+            performCalculation();
+
+        finishCalculation();
+    }
+
+    bool Feature::requestSampleStatistics(SampleStatistics* statistics) {
+        ensureInitialized();
+
+        return configureSampleStatistics(statistics);
+    }
+
+    void Feature::calculateFusedSamples(CircularArray* input_in, SampleStatistics* statistics) {
+        SIRENS_TIMER(getTimerName());
+
+        input = input_in;
+
+        ensureInitialized();
+
+        if (!performFusedSampleCalculation(statistics))
+            performCalculation();
+
+        finishCalculation();
+    }
+
     void Feature::waitForCompletion() {
         thread.wait();
     }
@@ -73,7 +190,7 @@ namespace Sirens {
         history->addValue(value);
     }
 
-    CircularArray* Feature::getHistory() {
+    FeatureHistory* Feature::getHistory() {
         return history;
     }
 
@@ -86,20 +203,11 @@ namespace Sirens {
     }
 
     int Feature::getMaxHistorySize() {
-        return history->getMaxSize();
+        return history->getBound();
     }
 
     void Feature::setMaxHistorySize(int history_size) {
-        CircularArray* new_history = new CircularArray(history_size);
-
-        if (history) {
-            for (int i = 0; i < history->getSize(); i++)
-                history->addValue(history->getValue(i));
-
-            delete history;
-        }
-
-        history = new_history;
+        history->setBound(history_size);
     }
 
     /*----------------*
@@ -127,7 +235,46 @@ namespace Sirens {
      *---------------*/
 
     SegmentationParameters* Feature::parameters() {
-        return segmentationParameters;
+        return &segmentationParameters;
+    }
+
+    /*----------------*
+     * Checkpointing. *
+     *----------------*/
+
+    void Feature::saveState(Checkpoint* checkpoint) {
+        checkpoint->writeString(toString());
+        checkpoint->writeDouble(value);
+        checkpoint->writeInt(history->getSize());
+        checkpoint->writeDoubles(history->getData(), history->getSize());
+
+        saveRunningState(checkpoint);
+    }
+
+    void Feature::loadState(Checkpoint* checkpoint) {
+        checkpoint->expectString(toString());
+
+        // Running state lives in buffers made on initialization.
+        ensureInitialized();
+
+        value = checkpoint->readDouble();
+
+        int history_size = checkpoint->readInt();
+
+        if (history_size < 0)
+            throw CheckpointException();
+
+        history->clear();
+        history->reserve(history_size);
+
+        if (history_size > 0) {
+            vector<double> values(history_size);
+            checkpoint->readDoubles(&values[0], history_size);
+
+            history->addValues(&values[0], history_size);
+        }
+
+        loadRunningState(checkpoint);
     }
 
     /*------------------------*
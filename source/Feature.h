@@ -26,24 +26,41 @@ using namespace std;
 
 #include "Thread.h"
 #include "CircularArray.h"
+#include "FeatureHistory.h"
 #include "SegmentationParameters.h"
+#include "Arena.h"
 
 namespace Sirens {
+    class SpectralStatistics;
+    class SampleStatistics;
+    
     class Feature {
     private:
         Thread thread;
 
         // Segmentation.
-        SegmentationParameters* segmentationParameters;
+        SegmentationParameters segmentationParameters;
 
         // History of every feature value calculated.
-        CircularArray* history;
+        FeatureHistory* history;
 
         // Normalization. Values are scaled between min and max.
         double min, max;
 
         // on-demand initialization, as some parameters may not be set on construction.
         virtual void initialize() {};
+        void ensureInitialized();
+
+        // normalizes the calculated value and adds it to the history.
+        void finishCalculation();
+
+        // not assignable; use clone().
+        Feature& operator=(const Feature& other);
+
+        // "feature:" and toString(), interned for timers (see
+        // Instrumentation), or NULL until first needed.
+        const char* timerName;
+        const char* getTimerName();
 
         // called on re-initialization, to free up any memory allocated at initialization.
         virtual void freeMemory() {};
@@ -55,20 +72,90 @@ namespace Sirens {
         // whether or not the feature has been initialized.
         bool initialized;
 
+        // arena for history and per-instance buffers, or NULL for the heap.
+        Arena* arena;
+
+        // Per-instance buffers. Subclasses allocate them in initialize and
+        // free them in freeMemory, so they come from the arena when one is
+        // set. freeBuffer sets the pointer to NULL.
+        template <class T> T* createBuffer(int count) {
+            if (arena)
+                return arena->allocate<T>(count);
+            else
+                return new T[count];
+        }
+
+        template <class T> void freeBuffer(T*& buffer) {
+            if (!arena)
+                delete [] buffer;
+
+            buffer = NULL;
+        }
+
         // actual value calculated.
         double value;
 
+        // Copies configuration, normalization, segmentation parameters and
+        // the history's bound, but not history or running state.
+        Feature(const Feature& other);
+
+        // clears running state kept between frames (filters, windows,
+        // previous frames), but not configuration or tables.
+        virtual void resetState() {}
+
+        // write and read back the same running state (see saveState).
+        virtual void saveRunningState(Checkpoint* checkpoint) {}
+        virtual void loadRunningState(Checkpoint* checkpoint) {}
+
     public:
-        Feature(int history_size = 1);
+        // history_size bounds the history to the newest history_size values;
+        // 0 keeps every value (see FeatureHistory).
+        Feature(int history_size = 0);
         virtual ~Feature();
 
-        // Calculation.
+        // Per-file memory. Once an arena is set, the history and per-instance
+        // buffers (which are rebuilt on the next calculation) are allocated
+        // from it. Like reset, this clears history and running state. Call
+        // setArena again after resetting the arena, and before the feature is
+        // used again.
+        void setArena(Arena* arena_in);
+        Arena* getArena();
+
+        // Reuse. reset clears history and running state so the feature can be
+        // used on another sound without reinitializing. clone returns a new
+        // feature (owned by the caller) with the same configuration and
+        // already initialized tables, but fresh state.
+        void reset();
+        virtual Feature* clone();
+
+        // Calculation. calculate runs in a new thread; calculateSynchronously
+        // runs in the calling thread.
         void calculate(CircularArray* input_in);
+        void calculateSynchronously(CircularArray* input_in);
         void prepareCalculation();
 
         // actual implementation.
         virtual void performCalculation() {}
 
+        // Fused spectral pass (see SpectralStatistics). Before the sweep,
+        // requestStatistics returns true if the feature will read its value
+        // from the shared statistics. calculateFused then runs in the calling
+        // thread, falling back to performCalculation if the statistics could
+        // not be configured the way the feature needs.
+        bool requestStatistics(SpectralStatistics* statistics);
+        void calculateFused(CircularArray* input_in, SpectralStatistics* statistics);
+
+        virtual bool configureStatistics(SpectralStatistics* statistics) {return false;}
+        virtual bool performFusedCalculation(SpectralStatistics* statistics) {return false;}
+
+        // The same for sample features, with the shared time-domain
+        // statistics (see SampleStatistics).
+        bool requestSampleStatistics(SampleStatistics* statistics);
+        void calculateFusedSamples(CircularArray* input_in, SampleStatistics* statistics);
+
+        virtual bool configureSampleStatistics(SampleStatistics* statistics) {return false;}
+        virtual bool performFusedSampleCalculation(SampleStatistics* statistics) {return false;}
+
         // blocks until the calculation is complete.
         void waitForCompletion();
 
@@ -78,9 +165,12 @@ namespace Sirens {
 
         // Adds a fake history frame--useful for loading from files etc.
         void addHistoryFrame(double value);
-        CircularArray* getHistory();
+        FeatureHistory* getHistory();
         double getHistoryFrame(int i);
         int getHistorySize();
+
+        // The history's bound, or 0 if it keeps every value. Changing it
+        // keeps the newest values.
         int getMaxHistorySize();
         void setMaxHistorySize(int history_size);
 
@@ -93,6 +183,13 @@ namespace Sirens {
         // Segmentation.
         SegmentationParameters* parameters();
 
+        // Checkpointing (see Checkpoint). saveState writes the history, the
+        // last value and running state; loadState reads them back into a
+        // feature of the same kind and configuration, throwing
+        // CheckpointException if it is another kind.
+        void saveState(Checkpoint* checkpoint);
+        void loadState(Checkpoint* checkpoint);
+
         // String representation.
         virtual const char* toString();
         string historyString();
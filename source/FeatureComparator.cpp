@@ -17,6 +17,9 @@
     along with Sirens. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <limits>
+using namespace std;
+
 #include <boost/numeric/ublas/vector_proxy.hpp>
 #include <boost/numeric/ublas/matrix_proxy.hpp>
 #include <boost/numeric/ublas/io.hpp>
@@ -27,12 +30,14 @@ using namespace boost::numeric;
 #include "matrix_support.h"
 #include "math_support.h"
 #include "savitzky_golay.h"
+#include "Instrumentation.h"
 
 namespace Sirens {
     FeatureComparator::FeatureComparator(Feature* feature_in) {
         feature = feature_in;
         initialized = false;
         bestFit = NULL;
+        states = 0;
     }
 
     FeatureComparator::~FeatureComparator() {
@@ -52,92 +57,112 @@ namespace Sirens {
      * Helpers. *
      *----------*/
     
-    // Fit a polynomial to the feature trajectory and compute the akaike information criterion for comparison to other curves.
-    void FeatureComparator::fitPolynomial(
-        LeastSquaresParameters* curve, 
-        ublas::vector<double>* concatonated_trajectory
-    ) {
+    // Fit a polynomial to the feature trajectory and compute the akaike
+    // information criterion for comparison to other curves. With t = 1..size,
+    // column k of the design matrix is t^p for positions and p * t^(p - 1) for
+    // velocities (p = order - k), so the normal equations reduce to power sums
+    // of t and t-weighted sums of the trajectory.
+    void FeatureComparator::fitPolynomial(LeastSquaresParameters* curve) {
         int size = trajectory.size2();
+        int columns = curve->order + 1;
         
-        ublas::matrix<double> x = ublas::zero_matrix<double>(
-            2 * size, 
-            curve->order + 1
-        );
+        // Closed-form power sums of t.
+        double n = size;
+        double power_sums[5];
+        power_sums[0] = n;
+        power_sums[1] = n * (n + 1) / 2;
+        power_sums[2] = n * (n + 1) * (2 * n + 1) / 6;
+        power_sums[3] = power_sums[1] * power_sums[1];
+        power_sums[4] = power_sums[2] * (3 * n * n + 3 * n - 1) / 5;
+        
+        double position_sums[3] = {0, 0, 0};
+        double velocity_sums[2] = {0, 0};
         
         for (int i = 0; i < size; i++) {
-            if (curve->order > 1) {
-                x(i, 0) = (i + 1) * (i + 1);
-                x(size + i, 0) = 2 * (i + 1);
-            }
+            double t = i + 1;
+            double position = trajectory(0, i);
+            double velocity = trajectory(1, i);
+            
+            position_sums[0] += position;
+            position_sums[1] += t * position;
+            position_sums[2] += t * t * position;
+            velocity_sums[0] += velocity;
+            velocity_sums[1] += t * velocity;
+        }
+        
+        // Normal equations X'X c = X'y, solved in place.
+        double normal[9];
+        double coefficients[3];
+        
+        for (int a = 0; a < columns; a++) {
+            int power_a = curve->order - a;
             
-            if (curve->order > 0) {
-                x(i, curve->order - 1) = (i + 1);
-                x(size + i, curve->order - 1) = 1;
+            for (int b = 0; b < columns; b++) {
+                int power_b = curve->order - b;
+                
+                normal[a * columns + b] = power_sums[power_a + power_b];
+                
+                if (power_a > 0 && power_b > 0)
+                    normal[a * columns + b] += power_a * power_b * power_sums[power_a + power_b - 2];
             }
             
-            x(i, curve->order) = 1;
-            x(size + i, curve->order) = 0;
+            coefficients[a] = position_sums[power_a];
+            
+            if (power_a > 0)
+                coefficients[a] += power_a * velocity_sums[power_a - 1];
         }
         
-        curve->coefficients = ublas::prod(
-            ublas::prod(
-                invert(
-                    ublas::prod(
-                        ublas::trans(x), 
-                        x
-                    )
-                ), 
-                ublas::trans(x)
-            ), 
-            (*concatonated_trajectory)
-        );
+        if (!solve_linear_system(normal, coefficients, columns)) {
+            for (int i = 0; i < columns; i++)
+                coefficients[i] = 0;
+        }
         
-        curve->trajectory = ublas::prod(x, curve->coefficients);
+        for (int i = 0; i < columns; i++)
+            curve->coefficients[i] = coefficients[i];
         
-        ublas::vector<double> error = (*concatonated_trajectory) - curve->trajectory;
+        // Fitted trajectory, residual sum of squares and residual covariance
+        // in one pass (running means and co-moments of the errors).
+        curve->trajectory.resize(2 * size);
         
         double rss = 0;
-        
-        for (int i = 0; i < error.size(); i++)
-            rss += error[i] * error[i];
-        
-        ublas::matrix<double> error_matrix = ublas::zero_matrix<double>(
-            2, 
-            size
-        );
-
-        for (int i = 0; i < size; i++) {
-            error_matrix(0, i) = error[i];
-            error_matrix(1, i) = error[size + i];
-        }
-        
-        // Calculate mean error for position and velocity trajectories.
-        ublas::vector<double> mean = ublas::zero_vector<double>(2);
+        double position_mean = 0;
+        double velocity_mean = 0;
+        double comoments[3] = {0, 0, 0};
         
         for (int i = 0; i < size; i++) {
-            mean += ublas::matrix_column<ublas::matrix<double> >(
-                error_matrix, 
-                i
-            );
+            double t = i + 1;
+            
+            // Horner's rule for the polynomial and its derivative.
+            double position = coefficients[0];
+            double velocity = 0;
+            
+            for (int k = 1; k < columns; k++) {
+                velocity = velocity * t + position;
+                position = position * t + coefficients[k];
+            }
+            
+            curve->trajectory[i] = position;
+            curve->trajectory[size + i] = velocity;
+            
+            double position_error = trajectory(0, i) - position;
+            double velocity_error = trajectory(1, i) - velocity;
+            
+            rss += position_error * position_error + velocity_error * velocity_error;
+            
+            double position_delta = position_error - position_mean;
+            double velocity_delta = velocity_error - velocity_mean;
+            position_mean += position_delta / t;
+            velocity_mean += velocity_delta / t;
+            
+            comoments[0] += position_delta * (position_error - position_mean);
+            comoments[1] += position_delta * (velocity_error - velocity_mean);
+            comoments[2] += velocity_delta * (velocity_error - velocity_mean);
         }
-
-        mean /= size;
-        
-        ublas::vector<double> ones(size);
-        
-        for (int i = 0; i < ones.size(); i++)
-            ones[i] = 1;
         
-        ublas::matrix<double> value = ublas::outer_prod(mean, ones);
-        
-        error_matrix = error_matrix - value;
-        curve->covariance = (1.0 / double(size - 1)) * 
-            ublas::prod(
-                error_matrix, 
-                ublas::trans(error_matrix)
-            ) + 
-            ublas::identity_matrix<double>(error_matrix.size1()) * 
-            0.00000000000001;
+        curve->covariance(0, 0) = comoments[0] / double(size - 1) + 0.00000000000001;
+        curve->covariance(0, 1) = comoments[1] / double(size - 1);
+        curve->covariance(1, 0) = comoments[1] / double(size - 1);
+        curve->covariance(1, 1) = comoments[2] / double(size - 1) + 0.00000000000001;
         
         // Compute akaike information criterion for comparison to other curve models.
         curve->aicc = akaike(curve->order + 1, 2 * size, rss);
@@ -169,83 +194,95 @@ namespace Sirens {
         }
     }
     
-    double FeatureComparator::forwardAlgorithm(
-        ublas::matrix<double> emission_probabilities
+    // Log emission probabilities of every state for one frame of a
+    // trajectory.
+    void FeatureComparator::logEmissions(
+        const ublas::matrix<double>& other_trajectory, 
+        int frame, 
+        double log_constant, 
+        FixedVector<5>& log_emissions
     ) {
-        int states = emission_probabilities.size1();
-        int observations = emission_probabilities.size2();
-        
-        ublas::matrix<double> alf = ublas::zero_matrix<double>(
-            observations, 
-            states
-        );
-
-        ublas::matrix<double> alf_h = ublas::zero_matrix<double>(
-            observations, 
-            states
-        );
-        
-        ublas::vector<double> first_frame = ublas::matrix_column<ublas::matrix<double> >(emission_probabilities, 0);
-        
-        ublas::vector<double> row(prior.size());
+        for (int i = 0; i < states; i++) {
+            Vector2 deviation;
+            deviation[0] = other_trajectory(0, frame) - bestFit->mean(0, i);
+            deviation[1] = other_trajectory(1, frame) - bestFit->mean(1, i);
+            
+            log_emissions[i] = log_constant - 
+                0.5 * quadratic_form(deviation, bestFit->covarianceInverse);
+        }
+    }
+    
+    // Logarithm of the sum of values given as logarithms. Terms more than 38
+    // below the largest change the sum by at most an ulp, so they are skipped
+    // rather than exponentiated (as are -infinity terms).
+    static double log_sum(const double* values, int count, double largest) {
+        const double minus_infinity = -numeric_limits<double>::infinity();
+        
+        if (largest == minus_infinity)
+            return minus_infinity;
+        
+        double sum = 0;
+        
+        for (int i = 0; i < count; i++) {
+            if (values[i] == largest)
+                sum += 1;
+            else if (values[i] > largest - 38)
+                sum += exp(values[i] - largest);
+        }
         
-        for (int i = 0; i < row.size(); i++)
-            row[i] = prior[i] * first_frame[i];
+        return (sum == 1) ? largest : largest + log(sum);
+    }
+    
+    // Forward algorithm in the log domain, so that long or poorly matching
+    // trajectories lower the likelihood rather than underflowing it.
+    double FeatureComparator::forwardAlgorithm(
+        const ublas::matrix<double>& other_trajectory, 
+        double log_constant
+    ) {
+        const double minus_infinity = -numeric_limits<double>::infinity();
+        int observations = other_trajectory.size2();
         
-        for (int i = 0; i < states; i++)
-            alf(0, i) = row[i];
+        // Log forward variables of the previous and current observation.
+        FixedVector<5> log_alpha;
+        FixedVector<5> next;
+        FixedVector<5> log_emissions;
         
-        ublas::vector<double> c(observations);
-        c[0] = 0;
+        logEmissions(other_trajectory, 0, log_constant, log_emissions);
         
-        for (int i = 0; i < alf.size2(); i++)
-            c[0] += alf(0, i);
+        for (int i = 0; i < states; i++) {
+            if (prior[i] > 0)
+                log_alpha[i] = log(prior[i]) + log_emissions[i];
+            else
+                log_alpha[i] = minus_infinity;
+        }
         
-        if (c[0] == 0)
-            return 0;
-        else {
-            for (int i = 0; i < states; i++)
-                alf_h(0, i) = alf(0, i) / c[0];
+        // Induction step. The HMM is left-to-right, so state i is only
+        // reached from states 0 to i.
+        for (int t = 1; t < observations; t++) {
+            logEmissions(other_trajectory, t, log_constant, log_emissions);
             
-            // Induction step.
-            for (int t = 1; t < observations; t++) {
-                ublas::vector<double> alf_h_row = ublas::matrix_row<ublas::matrix<double> >(alf_h, t - 1);
-                ublas::vector<double> temp = ublas::prod(
-                    alf_h_row, 
-                    transitions
-                );
+            for (int i = 0; i < states; i++) {
+                double terms[5];
+                double largest = minus_infinity;
                 
-                for (int i = 0; i < alf.size2(); i++) {
-                    alf(t, i) = temp[i] * emission_probabilities(i, t);
+                for (int j = 0; j <= i; j++) {
+                    terms[j] = log_alpha[j] + logTransitions(j, i);
+                    largest = maximum(largest, terms[j]);
                 }
                 
-                c[t] = 0;
-                
-                for (int i = 0; i < alf.size2(); i++)
-                    c[t] += alf(t, i);
-                
-                if (c[t] == 0) {
-                    for (int i = 0; i < alf_h.size2(); i++)
-                        alf_h(t, i) = 0;
-                    
-                    break;
-                } else {
-                    for (int i = 0; i < alf_h.size2(); i++)
-                        alf_h(t, i) = alf(t, i) / c[t];
-                }
-            }
-            
-            // Termination.
-            double log_likelihood = 0;
-            
-            for (int i = 0; i < c.size(); i++) {
-                if (c[i] != 0) {
-                    log_likelihood += log(c[i]);
-                }
+                next[i] = log_sum(terms, i + 1, largest) + log_emissions[i];
             }
             
-            return log_likelihood;
+            log_alpha = next;
         }
+        
+        // Termination.
+        double largest = minus_infinity;
+        
+        for (int i = 0; i < states; i++)
+            largest = maximum(largest, log_alpha[i]);
+        
+        return log_sum(log_alpha.data, states, largest);
     }
     
     /*-----------------*
@@ -255,67 +292,38 @@ namespace Sirens {
     // Savitzky-Golay smoothing of position and velocity vectors for feature
     // trajectory.
     void FeatureComparator::smooth() {
-        // Iteration variables.
-        int padding = (savitzky_golay_f + 1) / 2;
         int history_size = feature->getHistorySize();
-    
-        // Fill two vectors with the first 2 differentiation filters of a
-        // 4th-order SG filter for 41 frames.
-        ublas::vector<double> first;
-        ublas::vector<double> second;
-        fill_savitzky_golay(first, second);
-        
-        // Resize position and velocity vectors for filling.
-        trajectory.resize(2, history_size);
-        
-        // Fill the trajectory vector with history values, padded with 1s at
-        // the ends.
-        ublas::vector<double> padded_position(history_size + padding * 2);
-        for (int i = 0; i < padding; i++)
-            padded_position[i] = feature->getHistoryFrame(0);
-    
-        for (int i = history_size + padding - 1; i < history_size + padding * 2; i++)
-            padded_position[i] = feature->getHistoryFrame(history_size - 1);
-    
-        for (int i = padding; i < history_size + padding - 1; i++)
-            padded_position[i] = feature->getHistoryFrame(i - padding);
         
-        // Calculate smoothed position and velocity by sliding the SG filters
-        // across the trajectory.
-        for (int i = padding - 1; i < history_size + padding - 1; i++) {
-            int index = i - (padding - 1);
-            
-            ublas::vector<double> window(padding * 2 - 1);
-            
-            for (int j = 0; j < padding * 2 - 1; j++)
-                window[j] = padded_position[i - padding + 1 + j];
-            
-            trajectory(0, index) = ublas::inner_prod(first, window);
-            trajectory(1, index) = ublas::inner_prod(second, window);
-        }
+        // Row 0 is position, row 1 is velocity; rows are contiguous.
+        trajectory.resize(2, history_size, false);
+        
+        double* positions = trajectory.data().begin();
+        
+        savitzky_golay_smooth(
+            feature->getHistory()->getData(), 
+            history_size, 
+            0, 
+            history_size, 
+            positions, 
+            positions + history_size
+        );
     }
     
     void FeatureComparator::fitCurve() {
         int size = trajectory.size2();
         vector<LeastSquaresParameters*> curves(3);
-        ublas::vector<double>* concatonated_trajectory = new ublas::vector<double>(size * 2);
-        
-        for (int i = 0; i < size; i++) {
-            (*concatonated_trajectory)[i] = trajectory(0, i);
-            (*concatonated_trajectory)[i + size] = trajectory(1, i);
-        }
         
         for (int i = 0; i < 3; i++) {
             curves[i] = new LeastSquaresParameters();
             curves[i]->order = i;
             
-            fitPolynomial(curves[i], concatonated_trajectory);
+            fitPolynomial(curves[i]);
             
             if (bestFit == NULL || bestFit->aicc > curves[i]->aicc)
                 bestFit = curves[i];
         }
         
-        for (int i = 0; i < 2; i++) {
+        for (int i = 0; i < 3; i++) {
             if (bestFit != curves[i])
                 delete curves[i];
         }
@@ -325,7 +333,8 @@ namespace Sirens {
         bestFit->covarianceDeterminant = determinant(bestFit->covariance);
         bestFit->covarianceInverse = invert(bestFit->covariance);
         
-        bestFit->mean = ublas::zero_matrix<double>(2, 2 * bestFit->order + 1);
+        bestFit->mean.fill(0);
+        bestFit->timeSamples.fill(0);
         
         ublas::vector<double> positions = ublas::vector_range<ublas::vector<double> >(bestFit->trajectory, ublas::range(0, size));
         
@@ -338,12 +347,10 @@ namespace Sirens {
         
         if (bestFit->order == 0) {
             // Position state is constant.
-            bestFit->mean(0, 0) = bestFit->coefficients(0);
+            bestFit->mean(0, 0) = bestFit->coefficients[0];
 
             // Velocity state is 0.
             bestFit->mean(1, 0) = 0;
-            
-            bestFit->timeSamples = ublas::zero_vector<double>(1);   
         } else if (bestFit->order == 1) {
             double midpoint = round(double(size - 1) / 2.0);
             
@@ -353,17 +360,16 @@ namespace Sirens {
             bestFit->mean(0, 2) = positions[size - 1];
             
             // Velocity states are constant.
-            bestFit->mean(1, 0) = bestFit->coefficients(0);
-            bestFit->mean(1, 1) = bestFit->coefficients(0);
-            bestFit->mean(1, 2) = bestFit->coefficients(0);
+            bestFit->mean(1, 0) = bestFit->coefficients[0];
+            bestFit->mean(1, 1) = bestFit->coefficients[0];
+            bestFit->mean(1, 2) = bestFit->coefficients[0];
             
-            bestFit->timeSamples.resize(2);
             bestFit->timeSamples[0] = midpoint;
             bestFit->timeSamples[1] = size - 1 - midpoint;
         } else if (bestFit->order == 2) { 
             // vertex of parabola.
-            int vertex = round(-bestFit->coefficients(1) / 
-                (2.0 * bestFit->coefficients(0))) - 1; 
+            int vertex = round(-bestFit->coefficients[1] / 
+                (2.0 * bestFit->coefficients[0])) - 1; 
 
             if (vertex < 0 || vertex >= size)
                 vertex = round(double(size) / 2.0);
@@ -385,7 +391,6 @@ namespace Sirens {
             bestFit->mean(1, 3) = 2 * bestFit->coefficients[0] * (midpoint2 + 1) + bestFit->coefficients[1];
             bestFit->mean(1, 4) = 2 * bestFit->coefficients[0] * size + bestFit->coefficients[1];
             
-            bestFit->timeSamples.resize(4);
             bestFit->timeSamples[0] = midpoint1;
             bestFit->timeSamples[1] = vertex - midpoint1;
             bestFit->timeSamples[2] = midpoint2 - vertex;
@@ -394,18 +399,18 @@ namespace Sirens {
     }
         
     void FeatureComparator::createHMM() {
+        states = 2 * bestFit->order + 1;
+        
         // Create the prior state.
-        ublas::matrix<double> identity = ublas::identity_matrix<double>(
-            2 * bestFit->order + 1
-        );
-
-        prior = ublas::matrix_row<ublas::matrix<double> >(identity, 0);
+        prior.fill(0);
+        prior[0] = 1;
         
         // Create the transition probability matrix between states.
+        transitions.fill(0);
+        
         if (bestFit->order == 0)
-            transitions = ublas::scalar_matrix<double>(1, 1, 1.0);
+            transitions(0, 0) = 1;
         else if (bestFit->order == 1) {
-            transitions = ublas::zero_matrix<double>(3, 3);
             transitions(0, 0) = f0(bestFit->timeSamples[0]);
             transitions(0, 1) = f1(bestFit->timeSamples[0], bestFit->timeSamples[1]);
             transitions(0, 2) = f2(bestFit->timeSamples[0], bestFit->timeSamples[1]);
@@ -413,7 +418,6 @@ namespace Sirens {
             transitions(1, 2) = 1 - transitions(1, 1);
             transitions(2, 2) = 1;
         } else if (bestFit->order == 2) {
-            transitions = ublas::zero_matrix<double>(5, 5);
             transitions(0, 0) = f0(bestFit->timeSamples[0]);
             transitions(0, 1) = f1(bestFit->timeSamples[0], bestFit->timeSamples[1]);
             transitions(0, 2) = f2(bestFit->timeSamples[0], bestFit->timeSamples[1]);
@@ -427,6 +431,15 @@ namespace Sirens {
             transitions(3, 4) = 1 - transitions(3, 3);
             transitions(4, 4) = 1;
         }
+        
+        for (int i = 0; i < states; i++) {
+            for (int j = 0; j < states; j++) {
+                if (transitions(i, j) > 0)
+                    logTransitions(i, j) = log(transitions(i, j));
+                else
+                    logTransitions(i, j) = -numeric_limits<double>::infinity();
+            }
+        }
     }
 
     /*------------------------------*
@@ -442,11 +455,11 @@ namespace Sirens {
      *---------------------------*/
     
     ublas::matrix<double> FeatureComparator::getCovariance() {
-        return bestFit->covariance;
+        return to_ublas(bestFit->covariance);
     }
     
     ublas::matrix<double> FeatureComparator::getCovarianceInverse() {
-        return bestFit->covarianceInverse;
+        return to_ublas(bestFit->covarianceInverse);
     }
     
     double FeatureComparator::getCovarianceDeterminant() {
@@ -458,11 +471,11 @@ namespace Sirens {
      *-----------------*/
 
     ublas::vector<double> FeatureComparator::getPrior() {
-        return prior;
+        return to_ublas(prior, states);
     }
 
     ublas::matrix<double> FeatureComparator::getTransitions() {
-        return transitions;
+        return to_ublas(transitions, states, states);
     }
     
     /*-------------*
@@ -470,6 +483,8 @@ namespace Sirens {
      *-------------*/
 
     void FeatureComparator::initialize() {
+        SIRENS_TIMER(Instrumentation::intern(string("compare:initialize:") + feature->toString()));
+        
         smooth();
         fitCurve();
         createHMM();
@@ -482,41 +497,25 @@ namespace Sirens {
     }
     
     double FeatureComparator::compare(FeatureComparator* model) {
+        SIRENS_TIMER(Instrumentation::intern(string("compare:feature:") + feature->toString()));
+        
         if (!initialized)
             initialize();
         
         if (!model->isInitialized())
             model->initialize();
             
-        ublas::matrix<double> other_trajectory = model->getTrajectory();
+        const ublas::matrix<double>& other_trajectory = model->trajectory;
         
-        int states = prior.size();
         int frames = other_trajectory.size2();
         
-        // Compute emission probabilities for the feature trajectory.
-        ublas::matrix<double> emission_probabilities(states, frames);
-        
-        bool singular = (
-            bestFit->covarianceInverse.size1() == bestFit->covarianceInverse.size2() == 1 && 
-            bestFit->covarianceInverse(0, 0) == 0
-        );
+        // invert returns a zero matrix for a singular covariance.
+        bool singular = bestFit->covarianceInverse(0, 0) == 0;
         
         if (!singular) {
-            for (int i = 0; i < states; i++) {
-                for (int j = 0; j < frames; j++) {
-                    ublas::vector<double> frame = ublas::matrix_column<ublas::matrix<double> >(other_trajectory, j);
-                    ublas::vector<double> frame_mean = ublas::matrix_column<ublas::matrix<double> >(bestFit->mean, i);
-                    ublas::vector<double> deviation = frame - frame_mean;
-                    
-                    double constant = 1.0 / (2 * PI * sqrt(bestFit->covarianceDeterminant));
-                    double exponential = exp(-0.5 * ublas::inner_prod(ublas::prod(ublas::trans(deviation), bestFit->covarianceInverse), deviation));
-                    
-                    emission_probabilities(i, j) = constant * exponential;
-                    
-                }
-            }
+            double log_constant = -log(2 * PI * sqrt(bestFit->covarianceDeterminant));
             
-            return forwardAlgorithm(emission_probabilities) / double(frames);
+            return forwardAlgorithm(other_trajectory, log_constant) / double(frames);
         } else
             return 0;
     }
@@ -25,6 +25,7 @@
 using namespace boost::numeric;
 
 #include "Feature.h"
+#include "FixedMatrix.h"
 
 namespace Sirens {
     // Parameters for least-squares curve fitting.
@@ -32,15 +33,15 @@ namespace Sirens {
         // 0 = constant, 1 = linear, 2 = quadratic.
         int order;
         
-        ublas::matrix<double> covariance;
-        ublas::matrix<double> covarianceInverse;
+        Matrix2 covariance;
+        Matrix2 covarianceInverse;
         double covarianceDeterminant;
 
         // Smoothed trajectory from fit.
         ublas::vector<double> trajectory;
         
-        // Curve polynomial coefficients.
-        ublas::vector<double> coefficients;         
+        // Curve polynomial coefficients (order + 1 used).
+        FixedVector<3> coefficients;
 
         // Akaike information criterion.
         double aicc;
@@ -48,8 +49,10 @@ namespace Sirens {
         // mean of the observations.
         double xOffset;
         
-        ublas::matrix<double> mean;
-        ublas::vector<double> timeSamples;
+        // Position and velocity means of the 2 * order + 1 HMM states, and
+        // the durations between them.
+        FixedMatrix<2, 5> mean;
+        FixedVector<4> timeSamples;
     };
     
     // Class that creates a retrieval model for an individual feature
@@ -67,20 +70,29 @@ namespace Sirens {
         // Curve fitting.
         LeastSquaresParameters* bestFit;
         
-        // HMM.
-        ublas::vector<double> prior;
-        ublas::matrix<double> transitions;
+        // HMM, of which the leading states x states block is used.
+        // logTransitions is -infinity where a transition is impossible.
+        int states;
+        FixedVector<5> prior;
+        FixedMatrix<5, 5> transitions;
+        FixedMatrix<5, 5> logTransitions;
         
         // Helpers.
-        void fitPolynomial(
-            LeastSquaresParameters* curve, 
-            ublas::vector<double>* concatonated_trajectory
-        );
+        void fitPolynomial(LeastSquaresParameters* curve);
 
         double f0(double distance);
         double f1(double distance1, double distance2);
         double f2(double distance2, double distance3);
-        double forwardAlgorithm(ublas::matrix<double> emission_probabilities);
+        void logEmissions(
+            const ublas::matrix<double>& other_trajectory, 
+            int frame, 
+            double log_constant, 
+            FixedVector<5>& log_emissions
+        );
+        double forwardAlgorithm(
+            const ublas::matrix<double>& other_trajectory, 
+            double log_constant
+        );
         
         // Initialization.
 
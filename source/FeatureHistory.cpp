@@ -0,0 +1,167 @@
+/*
+    Copyright 2009 Arizona State University
+
+    This file is part of Sirens.
+
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+using namespace std;
+
+#include "FeatureHistory.h"
+
+#include "math_support.h"
+#include "string_support.h"
+
+namespace Sirens {
+    FeatureHistory::FeatureHistory(int bound_in, Arena* arena_in) {
+        data = NULL;
+        start = 0;
+        size = 0;
+        capacity = 0;
+        bound = maximum(bound_in, 0);
+        arena = arena_in;
+    }
+
+    FeatureHistory::~FeatureHistory() {
+        if (!arena)
+            delete [] data;
+    }
+
+    void FeatureHistory::reallocate(int new_capacity) {
+        double* new_data;
+
+        if (arena)
+            new_data = arena->allocate<double>(new_capacity);
+        else
+            new_data = new double[new_capacity];
+
+        if (size > 0)
+            memcpy(new_data, data + start, size * sizeof(double));
+
+        if (!arena)
+            delete [] data;
+
+        data = new_data;
+        start = 0;
+        capacity = new_capacity;
+    }
+
+    void FeatureHistory::makeRoom() {
+        if (start > 0 && start >= capacity / 2) {
+            // At least half the storage is behind the window, so the move is
+            // paid for by the values added since the last one. A bounded
+            // history at its full capacity of 2 * bound always ends up here.
+            memmove(data, data + start, size * sizeof(double));
+            start = 0;
+        } else {
+            int new_capacity = maximum(16, 2 * capacity);
+
+            if (bound > 0)
+                new_capacity = minimum(new_capacity, 2 * bound);
+
+            reallocate(new_capacity);
+        }
+    }
+
+    void FeatureHistory::addValue(double value) {
+        if (start + size == capacity)
+            makeRoom();
+
+        data[start + size] = value;
+
+        if (bound > 0 && size == bound)
+            start++;
+        else
+            size++;
+    }
+
+    void FeatureHistory::addValues(const double* values, int count) {
+        if (bound > 0 && count > bound) {
+            values += count - bound;
+            count = bound;
+        }
+
+        if (bound > 0 && size + count > bound) {
+            start += size + count - bound;
+            size = bound - count;
+        }
+
+        if (start + size + count > capacity) {
+            if (start > 0 && size + count <= capacity)
+                memmove(data, data + start, size * sizeof(double));
+            else {
+                int new_capacity = maximum(size + count, 2 * capacity);
+
+                if (bound > 0)
+                    new_capacity = maximum(size + count, minimum(new_capacity, 2 * bound));
+
+                reallocate(new_capacity);
+            }
+
+            start = 0;
+        }
+
+        memcpy(data + start + size, values, count * sizeof(double));
+        size += count;
+    }
+
+    void FeatureHistory::clear() {
+        start = 0;
+        size = 0;
+    }
+
+    void FeatureHistory::reserve(int count) {
+        if (bound > 0)
+            count = minimum(count, 2 * bound);
+
+        if (count > capacity)
+            reallocate(count);
+    }
+
+    int FeatureHistory::getSize() {
+        return size;
+    }
+
+    int FeatureHistory::getCapacity() {
+        return capacity;
+    }
+
+    int FeatureHistory::getBound() {
+        return bound;
+    }
+
+    void FeatureHistory::setBound(int bound_in) {
+        bound = maximum(bound_in, 0);
+
+        if (bound > 0 && size > bound) {
+            start += size - bound;
+            size = bound;
+        }
+    }
+
+    string FeatureHistory::toString() {
+        string history_string;
+
+        history_string =
+            "Bound: " + double_to_string(bound) +
+            ", Size: " + double_to_string(size) + "\n\t";
+
+        for (int i = 0; i < size; i++)
+            history_string += double_to_string(getValue(i)) + " ";
+
+        return history_string;
+    }
+}
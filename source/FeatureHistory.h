@@ -0,0 +1,108 @@
+/*
+    Copyright 2009 Arizona State University
+
+    This file is part of Sirens.
+
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_FEATUREHISTORY_H
+#define SIRENS_FEATUREHISTORY_H
+
+#include <string>
+using namespace std;
+
+#include "Arena.h"
+
+/*
+    FeatureHistory - the values a feature has calculated, oldest first, in
+        contiguous storage, so comparators and the segmenter can read them
+        as a plain array (getData).
+    
+    By default the history grows as needed, doubling its storage, so the
+    number of frames doesn't have to be known up front. With a bound it keeps
+    only the newest bound values, for streaming use; the window stays
+    contiguous by moving it back to the front of the storage, which costs at
+    most one copy per value added.
+    
+    With an arena, storage comes from it and outgrown storage isn't reclaimed
+    until the arena is reset. reserve ahead of time avoids that when the
+    number of frames is known.
+*/
+
+namespace Sirens {
+    class FeatureHistory {
+    private:
+        double* data;
+
+        // Index of the oldest value in data, and the number of values.
+        int start;
+        int size;
+
+        // Values allocated.
+        int capacity;
+
+        // Maximum number of values kept, or 0 to keep all of them.
+        int bound;
+
+        // Arena the data was allocated from, if any.
+        Arena* arena;
+
+        // Makes room for one more value after the newest, by moving the
+        // window to the front or by growing.
+        void makeRoom();
+        void reallocate(int new_capacity);
+
+        // Not copyable.
+        FeatureHistory(const FeatureHistory& other);
+        FeatureHistory& operator=(const FeatureHistory& other);
+
+    public:
+        FeatureHistory(int bound_in = 0, Arena* arena_in = NULL);
+        ~FeatureHistory();
+
+        void addValue(double value);
+        void addValues(const double* values, int count);
+
+        // Empties the history without freeing it.
+        void clear();
+
+        // Allocates room for at least count values.
+        void reserve(int count);
+
+        int getSize();
+        int getCapacity();
+
+        // Changing the bound keeps the newest values.
+        int getBound();
+        void setBound(int bound_in);
+
+        double getValue(int offset) {
+            return data[start + offset];
+        }
+
+        double getLatestValue() {
+            return data[start + size - 1];
+        }
+
+        // The values, oldest first. Valid until the next value is added.
+        const double* getData() {
+            return data + start;
+        }
+
+        string toString();
+    };
+}
+
+#endif
@@ -19,11 +19,18 @@
 
 #include "FeatureSet.h"
 
+#include "TrajectoryFile.h"
 #include "string_support.h"
+#include "Instrumentation.h"
 
 // TODO: Handling three separate feature vectors is ridiculous.
 
 namespace Sirens {
+    FeatureSet::FeatureSet() {
+        fusedSpectralPass = false;
+        threaded = true;
+    }
+    
     void FeatureSet::addSampleFeature(Feature* feature) {
         sampleFeatures.push_back(feature);
         features.push_back(feature);
@@ -52,6 +59,11 @@ namespace Sirens {
         spectralFeatures.clear();
     }
     
+    void FeatureSet::setArena(Arena* arena) {
+        for (unsigned int i = 0; i < features.size(); i++)
+            features[i]->setArena(arena);
+    }
+    
     int FeatureSet::getMinHistorySize() {
         int min_history_size = -1;
 
@@ -67,6 +79,22 @@ namespace Sirens {
         return min_history_size;
     }
 
+    void FeatureSet::setFusedSpectralPass(bool fused_spectral_pass) {
+        fusedSpectralPass = fused_spectral_pass;
+    }
+    
+    bool FeatureSet::getFusedSpectralPass() {
+        return fusedSpectralPass;
+    }
+    
+    void FeatureSet::setThreaded(bool threaded_in) {
+        threaded = threaded_in;
+    }
+    
+    bool FeatureSet::getThreaded() {
+        return threaded;
+    }
+
     void FeatureSet::saveCSV(string csv_path) {
         vector<vector<double> > trajectories;
 
@@ -83,20 +111,126 @@ namespace Sirens {
 
         write_csv_file(csv_path, trajectories);
     }
+    
+    void FeatureSet::saveTrajectories(
+        string path, 
+        double sample_rate, 
+        double hop_size, 
+        int value_size
+    ) {
+        TrajectoryFile::save(
+            path, 
+            getFeatures(), 
+            sample_rate, 
+            hop_size, 
+            value_size, 
+            getMinHistorySize()
+        );
+    }
+
+    void FeatureSet::saveState(Checkpoint* checkpoint) {
+        checkpoint->writeInt(features.size());
+
+        for (int i = 0; i < features.size(); i++)
+            features[i]->saveState(checkpoint);
+    }
+
+    void FeatureSet::loadState(Checkpoint* checkpoint) {
+        checkpoint->expectInt(features.size());
+
+        for (int i = 0; i < features.size(); i++)
+            features[i]->loadState(checkpoint);
+    }
+
+    void FeatureSet::startCalculation(Feature* feature, CircularArray* input) {
+        if (threaded)
+            feature->calculate(input);
+        else
+            feature->calculateSynchronously(input);
+    }
+    
+    void FeatureSet::finishCalculation(Feature* feature) {
+        if (threaded)
+            feature->waitForCompletion();
+    }
 
     void FeatureSet::calculateSampleFeatures(CircularArray* sample_array) {
-        for (unsigned int j = 0; j < sampleFeatures.size(); j++)
-            sampleFeatures[j]->calculate(sample_array);
+        SIRENS_TIMER("extract:sample_features");
+        
+        // Features that use the shared statistics read them in this thread;
+        // the rest are calculated on their own threads, if threaded.
+        usesSampleStatistics.resize(sampleFeatures.size());
+        
+        bool any_uses_statistics = false;
+        
+        for (unsigned int j = 0; j < sampleFeatures.size(); j++) {
+            usesSampleStatistics[j] = sampleFeatures[j]->requestSampleStatistics(&sampleStatistics);
+            
+            if (usesSampleStatistics[j])
+                any_uses_statistics = true;
+            else
+                startCalculation(sampleFeatures[j], sample_array);
+        }
+        
+        if (any_uses_statistics) {
+            {
+                SIRENS_TIMER("extract:sample_statistics");
+                
+                sampleStatistics.calculate(sample_array);
+            }
+            
+            for (unsigned int j = 0; j < sampleFeatures.size(); j++) {
+                if (usesSampleStatistics[j])
+                    sampleFeatures[j]->calculateFusedSamples(sample_array, &sampleStatistics);
+            }
+        }
 
-        for (unsigned int j = 0; j < sampleFeatures.size(); j++)
-            sampleFeatures[j]->waitForCompletion();
+        for (unsigned int j = 0; j < sampleFeatures.size(); j++) {
+            if (!usesSampleStatistics[j])
+                finishCalculation(sampleFeatures[j]);
+        }
     }
 
     void FeatureSet::calculateSpectralFeatures(CircularArray* spectrum_array) {
+        SIRENS_TIMER("extract:spectral_features");
+        
+        if (!fusedSpectralPass) {
+            for (unsigned int j = 0; j < spectralFeatures.size(); j++)
+                startCalculation(spectralFeatures[j], spectrum_array);
+
+            for (unsigned int j = 0; j < spectralFeatures.size(); j++)
+                finishCalculation(spectralFeatures[j]);
+            
+            return;
+        }
+        
+        // Collect what each feature needs, then sweep the spectrum once.
+        usesStatistics.resize(spectralFeatures.size());
+        
         for (unsigned int j = 0; j < spectralFeatures.size(); j++)
-            spectralFeatures[j]->calculate(spectrum_array);
-
-        for (unsigned int j = 0; j < spectralFeatures.size(); j++)
-            spectralFeatures[j]->waitForCompletion();
+            usesStatistics[j] = spectralFeatures[j]->requestStatistics(&statistics);
+        
+        {
+            SIRENS_TIMER("extract:spectral_statistics");
+            
+            statistics.calculate(spectrum_array);
+        }
+        
+        // Features that don't use the statistics still get their own threads,
+        // if threaded.
+        for (unsigned int j = 0; j < spectralFeatures.size(); j++) {
+            if (!usesStatistics[j])
+                startCalculation(spectralFeatures[j], spectrum_array);
+        }
+        
+        for (unsigned int j = 0; j < spectralFeatures.size(); j++) {
+            if (usesStatistics[j])
+                spectralFeatures[j]->calculateFused(spectrum_array, &statistics);
+        }
+        
+        for (unsigned int j = 0; j < spectralFeatures.size(); j++) {
+            if (!usesStatistics[j])
+                finishCalculation(spectralFeatures[j]);
+        }
     }
 }
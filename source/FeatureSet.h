@@ -22,6 +22,8 @@
 
 #include "Feature.h"
 #include "CircularArray.h"
+#include "SpectralStatistics.h"
+#include "SampleStatistics.h"
 
 /*
     FeatureSet - contains multiple features that are calculated on either
@@ -37,8 +39,28 @@ namespace Sirens {
         vector<Feature*> features;
         vector<Feature*> sampleFeatures;
         vector<Feature*> spectralFeatures;
+        
+        // Fused spectral pass. When enabled, spectral features that support it
+        // share a single sweep over the spectrum (see SpectralStatistics).
+        bool fusedSpectralPass;
+        SpectralStatistics statistics;
+        vector<bool> usesStatistics;
+        
+        // Time-domain statistics shared by the sample features. Always used.
+        SampleStatistics sampleStatistics;
+        vector<bool> usesSampleStatistics;
+        
+        // Whether features that don't use shared statistics are calculated
+        // on their own threads. Defaults to true.
+        bool threaded;
+        
+        void startCalculation(Feature* feature, CircularArray* input);
+        void finishCalculation(Feature* feature);
 
     public:
+        FeatureSet();
+        
+
         void addSampleFeature(Feature* feature);
         void addSpectralFeature(Feature* feature);
 
@@ -48,10 +70,33 @@ namespace Sirens {
 
         void clearFeatures();
         
+        // Sets the arena of every feature (see Feature::setArena).
+        void setArena(Arena* arena);
+        
         int getMinHistorySize();
+        
+        void setFusedSpectralPass(bool fused_spectral_pass);
+        bool getFusedSpectralPass();
+        
+        void setThreaded(bool threaded_in);
+        bool getThreaded();
 
         // Saves a CSV file containing the features' trajectories.
         void saveCSV(string csv_path);
+        
+        // Saves the same trajectories as a binary trajectory file (see
+        // TrajectoryFile), with float64 (value_size 8) or float32 values.
+        void saveTrajectories(
+            string path, 
+            double sample_rate, 
+            double hop_size, 
+            int value_size = 8
+        );
+
+        // Checkpointing (see Checkpoint). Every feature's state, in order;
+        // loadState throws CheckpointException if the features differ.
+        void saveState(Checkpoint* checkpoint);
+        void loadState(Checkpoint* checkpoint);
 
         void calculateSampleFeatures(CircularArray* sample_array);
         void calculateSpectralFeatures(CircularArray* spectrum_array);
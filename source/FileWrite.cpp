@@ -0,0 +1,243 @@
+/***************************************************/
+/*! \class FileWrite
+    \brief STK audio file output class.
+
+    This class provides output support for WAV
+    files, the counterpart of FileRead.  Multi-
+    channel (>2) soundfiles are supported.  The
+    file data is passed to the write() function
+    interleaved, in an StkFrames object or an
+    array, and is written directly to disk.
+
+    Signed integer (8-, 16-, 24-, and 32-bit) and
+    floating-point (32- and 64-bit) data types are
+    supported.  As with FileRead, data can be given
+    normalized or, with doNormalize false, in the
+    range of the data type, so that samples read
+    without normalization are written back as they
+    were.
+
+    Reduced from the STK FileWrite class, by
+    Perry R. Cook and Gary P. Scavone, 1995 - 2007.
+*/
+/***************************************************/
+
+#include "FileWrite.h"
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+
+namespace stk {
+
+// WAV format tags.
+static const SINT16 WAVE_FORMAT_PCM = 0x0001;
+static const SINT16 WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+
+// Offsets of the sizes filled in on closing.
+static const long RIFF_SIZE_OFFSET = 4;
+static const long DATA_SIZE_OFFSET = 40;
+static const long HEADER_SIZE = 44;
+
+// Stores a value in the file's little-endian byte order.
+static void putLittleEndian( unsigned char *ptr, unsigned long value, int bytes )
+{
+  for ( int i=0; i<bytes; i++ )
+    ptr[i] = (unsigned char) ( ( value >> ( 8 * i ) ) & 0xff );
+}
+
+// Rounds and clips a value to [low, high].
+static SINT32 clipSample( StkFloat value, StkFloat low, StkFloat high )
+{
+  if ( value < low ) value = low;
+  if ( value > high ) value = high;
+  return (SINT32) floor( value + 0.5 );
+}
+
+FileWrite :: FileWrite()
+  : fd_(0), channels_(0), dataType_(0), frameCounter_(0), encoded_(0), encodedSize_(0)
+{
+}
+
+FileWrite :: FileWrite( std::string fileName, unsigned int nChannels, StkFormat format, StkFloat rate )
+  : fd_(0), channels_(0), dataType_(0), frameCounter_(0), encoded_(0), encodedSize_(0)
+{
+  open( fileName, nChannels, format, rate );
+}
+
+FileWrite :: ~FileWrite()
+{
+  close();
+  delete [] encoded_;
+}
+
+void FileWrite :: close( void )
+{
+  if ( fd_ == 0 ) return;
+
+  // Fill in the RIFF and data chunk sizes.
+  unsigned char bytes[4];
+  unsigned long dataSize = frameCounter_ * channels_ * sampleSize();
+
+  putLittleEndian( bytes, dataSize + HEADER_SIZE - 8, 4 );
+  fseek( fd_, RIFF_SIZE_OFFSET, SEEK_SET );
+  fwrite( bytes, 4, 1, fd_ );
+
+  putLittleEndian( bytes, dataSize, 4 );
+  fseek( fd_, DATA_SIZE_OFFSET, SEEK_SET );
+  fwrite( bytes, 4, 1, fd_ );
+
+  fclose( fd_ );
+  fd_ = 0;
+}
+
+bool FileWrite :: isOpen( void )
+{
+  if ( fd_ ) return true;
+  else return false;
+}
+
+unsigned int FileWrite :: sampleSize( void ) const
+{
+  if ( dataType_ == STK_SINT8 ) return 1;
+  else if ( dataType_ == STK_SINT16 ) return 2;
+  else if ( dataType_ == STK_SINT24 ) return 3;
+  else if ( dataType_ == STK_SINT32 || dataType_ == STK_FLOAT32 ) return 4;
+  else return 8;
+}
+
+void FileWrite :: open( std::string fileName, unsigned int nChannels, StkFormat format, StkFloat rate )
+{
+  close();
+
+  if ( nChannels < 1 ) {
+    oStream_ << "FileWrite::open: the channels argument must be greater than zero!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  if ( format != STK_SINT8 && format != STK_SINT16 && format != STK_SINT24 &&
+       format != STK_SINT32 && format != STK_FLOAT32 && format != STK_FLOAT64 ) {
+    oStream_ << "FileWrite::open: unknown data type (" << format << ") specified!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  fileName_ = fileName;
+  channels_ = nChannels;
+  dataType_ = format;
+  frameCounter_ = 0;
+
+  fd_ = fopen( fileName.c_str(), "wb" );
+  if ( !fd_ ) {
+    oStream_ << "FileWrite::open: could not create WAV file: " << fileName;
+    handleError( StkError::FILE_ERROR );
+  }
+
+  // The canonical 44-byte header, with the sizes left for closing.
+  unsigned char header[HEADER_SIZE];
+  unsigned int bytesPerSample = sampleSize();
+  bool isFloat = ( dataType_ == STK_FLOAT32 || dataType_ == STK_FLOAT64 );
+
+  memcpy( header, "RIFF", 4 );
+  putLittleEndian( header + 4, 0, 4 );
+  memcpy( header + 8, "WAVE", 4 );
+  memcpy( header + 12, "fmt ", 4 );
+  putLittleEndian( header + 16, 16, 4 );
+  putLittleEndian( header + 20, isFloat ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM, 2 );
+  putLittleEndian( header + 22, channels_, 2 );
+  putLittleEndian( header + 24, (unsigned long) rate, 4 );
+  putLittleEndian( header + 28, (unsigned long) rate * channels_ * bytesPerSample, 4 );
+  putLittleEndian( header + 32, channels_ * bytesPerSample, 2 );
+  putLittleEndian( header + 34, 8 * bytesPerSample, 2 );
+  memcpy( header + 36, "data", 4 );
+  putLittleEndian( header + 40, 0, 4 );
+
+  if ( fwrite( header, HEADER_SIZE, 1, fd_ ) != 1 ) {
+    oStream_ << "FileWrite::open: error writing WAV file header: " << fileName;
+    handleError( StkError::FILE_ERROR );
+  }
+}
+
+void FileWrite :: write( StkFrames& buffer, bool doNormalize )
+{
+  if ( buffer.channels() != channels_ ) {
+    oStream_ << "FileWrite::write: number of channels in the StkFrames argument does not match that in the file!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  if ( buffer.frames() == 0 ) return;
+
+  write( &buffer[0], buffer.frames(), doNormalize );
+}
+
+void FileWrite :: write( const StkFloat *data, unsigned long nFrames, bool doNormalize )
+{
+  if ( fd_ == 0 ) {
+    oStream_ << "FileWrite::write(): a file has not yet been opened!";
+    handleError( StkError::WARNING );
+    return;
+  }
+
+  unsigned long nSamples = nFrames * channels_;
+  unsigned int bytesPerSample = sampleSize();
+  unsigned long size = nSamples * bytesPerSample;
+
+  if ( size == 0 ) return;
+
+  if ( size > encodedSize_ ) {
+    delete [] encoded_;
+    encoded_ = new unsigned char[size];
+    encodedSize_ = size;
+  }
+
+  unsigned char *ptr = encoded_;
+  unsigned long i;
+
+  // Integer data, scaled as FileRead normalizes it.
+  if ( dataType_ == STK_SINT8 ) {
+    StkFloat gain = doNormalize ? 128.0 : 1.0;
+    for ( i=0; i<nSamples; i++ ) // 8-bit WAV data is unsigned!
+      *ptr++ = (unsigned char) ( clipSample( data[i] * gain, -128.0, 127.0 ) + 128 );
+  }
+  else if ( dataType_ == STK_SINT16 ) {
+    StkFloat gain = doNormalize ? 32768.0 : 1.0;
+    for ( i=0; i<nSamples; i++, ptr += 2 )
+      putLittleEndian( ptr, (unsigned long) clipSample( data[i] * gain, -32768.0, 32767.0 ), 2 );
+  }
+  else if ( dataType_ == STK_SINT24 ) {
+    StkFloat gain = doNormalize ? 8388608.0 : 1.0;
+    for ( i=0; i<nSamples; i++, ptr += 3 )
+      putLittleEndian( ptr, (unsigned long) clipSample( data[i] * gain, -8388608.0, 8388607.0 ), 3 );
+  }
+  else if ( dataType_ == STK_SINT32 ) {
+    StkFloat gain = doNormalize ? 2147483648.0 : 1.0;
+    for ( i=0; i<nSamples; i++, ptr += 4 )
+      putLittleEndian( ptr, (unsigned long) clipSample( data[i] * gain, -2147483648.0, 2147483647.0 ), 4 );
+  }
+  // Floating-point data is normalized either way.
+  else if ( dataType_ == STK_FLOAT32 ) {
+    for ( i=0; i<nSamples; i++, ptr += 4 ) {
+      FLOAT32 value = (FLOAT32) data[i];
+      memcpy( ptr, &value, 4 );
+#ifndef __LITTLE_ENDIAN__
+      swap32( ptr );
+#endif
+    }
+  }
+  else {
+    for ( i=0; i<nSamples; i++, ptr += 8 ) {
+      FLOAT64 value = (FLOAT64) data[i];
+      memcpy( ptr, &value, 8 );
+#ifndef __LITTLE_ENDIAN__
+      swap64( ptr );
+#endif
+    }
+  }
+
+  if ( fwrite( encoded_, size, 1, fd_ ) != 1 ) {
+    oStream_ << "FileWrite::write(): error writing data to file: " << fileName_;
+    handleError( StkError::FILE_ERROR );
+  }
+
+  frameCounter_ += nFrames;
+}
+
+} // stk namespace
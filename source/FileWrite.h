@@ -0,0 +1,98 @@
+#ifndef STK_FILEWRITE_H
+#define STK_FILEWRITE_H
+
+#include "Stk.h"
+
+namespace stk {
+
+/***************************************************/
+/*! \class FileWrite
+    \brief STK audio file output class.
+
+    This class provides output support for WAV
+    files, the counterpart of FileRead.  Multi-
+    channel (>2) soundfiles are supported.  The
+    file data is passed to the write() function
+    interleaved, in an StkFrames object or an
+    array, and is written directly to disk.
+
+    Signed integer (8-, 16-, 24-, and 32-bit) and
+    floating-point (32- and 64-bit) data types are
+    supported.  As with FileRead, data can be given
+    normalized or, with doNormalize false, in the
+    range of the data type, so that samples read
+    without normalization are written back as they
+    were.
+
+    The header is written on opening and its sizes
+    are filled in on closing.
+
+    Reduced from the STK FileWrite class, by
+    Perry R. Cook and Gary P. Scavone, 1995 - 2007.
+*/
+/***************************************************/
+
+class FileWrite : public Stk
+{
+ public:
+
+  //! Default constructor.
+  FileWrite( void );
+
+  //! Overloaded constructor that opens a file during instantiation.
+  /*!
+    An StkError is thrown if the file cannot be opened.
+  */
+  FileWrite( std::string fileName, unsigned int nChannels = 1,
+             StkFormat format = STK_SINT16, StkFloat rate = 44100.0 );
+
+  //! Class destructor, which closes the file.
+  ~FileWrite( void );
+
+  //! Create a WAV file and write its header.
+  /*!
+    An existing file of the same name is replaced.  An StkError is
+    thrown if the file cannot be opened.
+  */
+  void open( std::string fileName, unsigned int nChannels = 1,
+             StkFormat format = STK_SINT16, StkFloat rate = 44100.0 );
+
+  //! If a file is open, fill in its header and close it.
+  void close( void );
+
+  //! Returns \e true if a file is currently open.
+  bool isOpen( void );
+
+  //! Return the number of sample frames written.
+  unsigned long frameCounter( void ) const { return frameCounter_; };
+
+  //! Write sample frames from an StkFrames object to the file.
+  /*!
+    An StkError is thrown if a file error occurs or if the number of
+    channels in the StkFrames argument is not equal to that in the
+    file.  Values out of the range of the data type are clipped.
+  */
+  void write( StkFrames& buffer, bool doNormalize = true );
+
+  //! Write \c nFrames interleaved sample frames to the file.
+  void write( const StkFloat *data, unsigned long nFrames, bool doNormalize = true );
+
+ protected:
+
+  // Size in bytes of one sample of the data type.
+  unsigned int sampleSize( void ) const;
+
+  FILE *fd_;
+  std::string fileName_;
+  unsigned int channels_;
+  StkFormat dataType_;
+  unsigned long frameCounter_;
+
+  // Encoded samples, reused from one write to the next.
+  unsigned char *encoded_;
+  unsigned long encodedSize_;
+};
+
+} // stk namespace
+
+#endif
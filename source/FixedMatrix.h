@@ -0,0 +1,198 @@
+/*
+    Copyright 2009 Arizona State University
+
+    This file is part of Sirens.
+
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_FIXEDMATRIX_H
+#define SIRENS_FIXEDMATRIX_H
+
+// Small vectors and matrices whose dimensions are template parameters. They are
+// stored inline rather than on the heap, and every loop over them has a
+// constant trip count, so operations compile to unrolled, register-resident
+// code. They hold the 2x2 covariances and the up-to-5x5 HMM matrices used in
+// retrieval and segmentation; data whose size depends on the sound (such as
+// trajectories) stays in ublas.
+namespace Sirens {
+    template <int Size>
+    class FixedVector {
+    public:
+        double data[Size];
+
+        FixedVector() {
+            fill(0);
+        }
+
+        explicit FixedVector(double value) {
+            fill(value);
+        }
+
+        void fill(double value) {
+            for (int i = 0; i < Size; i++)
+                data[i] = value;
+        }
+
+        int size() const {
+            return Size;
+        }
+
+        double& operator[](int i) {
+            return data[i];
+        }
+
+        const double& operator[](int i) const {
+            return data[i];
+        }
+    };
+
+    template <int Rows, int Columns>
+    class FixedMatrix {
+    public:
+        double data[Rows][Columns];
+
+        FixedMatrix() {
+            fill(0);
+        }
+
+        explicit FixedMatrix(double value) {
+            fill(value);
+        }
+
+        static FixedMatrix identity() {
+            FixedMatrix result;
+
+            for (int i = 0; i < Rows && i < Columns; i++)
+                result.data[i][i] = 1;
+
+            return result;
+        }
+
+        void fill(double value) {
+            for (int row = 0; row < Rows; row++) {
+                for (int column = 0; column < Columns; column++)
+                    data[row][column] = value;
+            }
+        }
+
+        int size1() const {
+            return Rows;
+        }
+
+        int size2() const {
+            return Columns;
+        }
+
+        double& operator()(int row, int column) {
+            return data[row][column];
+        }
+
+        const double& operator()(int row, int column) const {
+            return data[row][column];
+        }
+    };
+
+    typedef FixedVector<2> Vector2;
+    typedef FixedMatrix<2, 2> Matrix2;
+
+    /*-------------*
+     * Arithmetic. *
+     *-------------*/
+
+    template <int Rows, int Inner, int Columns>
+    inline FixedMatrix<Rows, Columns> prod(
+        const FixedMatrix<Rows, Inner>& a,
+        const FixedMatrix<Inner, Columns>& b
+    ) {
+        FixedMatrix<Rows, Columns> result;
+
+        for (int row = 0; row < Rows; row++) {
+            for (int column = 0; column < Columns; column++) {
+                for (int i = 0; i < Inner; i++)
+                    result.data[row][column] += a.data[row][i] * b.data[i][column];
+            }
+        }
+
+        return result;
+    }
+
+    // Matrix times column vector.
+    template <int Rows, int Columns>
+    inline FixedVector<Rows> prod(
+        const FixedMatrix<Rows, Columns>& a,
+        const FixedVector<Columns>& x
+    ) {
+        FixedVector<Rows> result;
+
+        for (int row = 0; row < Rows; row++) {
+            for (int column = 0; column < Columns; column++)
+                result.data[row] += a.data[row][column] * x.data[column];
+        }
+
+        return result;
+    }
+
+    // Row vector times matrix.
+    template <int Rows, int Columns>
+    inline FixedVector<Columns> prod(
+        const FixedVector<Rows>& x,
+        const FixedMatrix<Rows, Columns>& a
+    ) {
+        FixedVector<Columns> result;
+
+        for (int row = 0; row < Rows; row++) {
+            for (int column = 0; column < Columns; column++)
+                result.data[column] += x.data[row] * a.data[row][column];
+        }
+
+        return result;
+    }
+
+    template <int Rows, int Columns>
+    inline FixedMatrix<Columns, Rows> trans(const FixedMatrix<Rows, Columns>& a) {
+        FixedMatrix<Columns, Rows> result;
+
+        for (int row = 0; row < Rows; row++) {
+            for (int column = 0; column < Columns; column++)
+                result.data[column][row] = a.data[row][column];
+        }
+
+        return result;
+    }
+
+    template <int Size>
+    inline double inner_prod(
+        const FixedVector<Size>& x,
+        const FixedVector<Size>& y
+    ) {
+        double result = 0;
+
+        for (int i = 0; i < Size; i++)
+            result += x.data[i] * y.data[i];
+
+        return result;
+    }
+
+    // x' A x.
+    template <int Size>
+    inline double quadratic_form(
+        const FixedVector<Size>& x,
+        const FixedMatrix<Size, Size>& a
+    ) {
+        return inner_prod(prod(x, a), x);
+    }
+}
+
+#endif
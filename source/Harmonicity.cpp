@@ -21,9 +21,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 using namespace std;
 
 #include "math_support.h"
+#include "SlidingMaximum.h"
+#include "SpectralStatistics.h"
 
 namespace Sirens {
     Harmonicity::Harmonicity(
@@ -37,6 +40,9 @@ namespace Sirens {
         rawMagnitudes.values = NULL;
         accIndices.values = NULL;
         peakList.values = NULL;
+        windowIndices = NULL;
+        lattice = NULL;
+        latticeByRatio = NULL;
         
         setSpectrumSize(spectrum_size);
         setSampleRate(sample_rate);
@@ -48,6 +54,44 @@ namespace Sirens {
         setLPFCoefficient(0.7);
     }
 
+    Harmonicity::Harmonicity(const Harmonicity& other) : Feature(other) {
+        rawIndices.values = NULL;
+        rawMagnitudes.values = NULL;
+        accIndices.values = NULL;
+        peakList.values = NULL;
+        windowIndices = NULL;
+        lattice = NULL;
+        latticeByRatio = NULL;
+        
+        spectrumSize = other.spectrumSize;
+        sampleRate = other.sampleRate;
+        absThreshold = other.absThreshold;
+        threshold = other.threshold;
+        searchRegionLength = other.searchRegionLength;
+        maxPeaks = other.maxPeaks;
+        lpfCoefficient = other.lpfCoefficient;
+        
+        if (initialized) {
+            fftSize = other.fftSize;
+            minFrequencyIndex = other.minFrequencyIndex;
+            maxFrequencyIndex = other.maxFrequencyIndex;
+            searchRegionLength2 = other.searchRegionLength2;
+            nMax = other.nMax;
+            kVar = other.kVar;
+            
+            createBuffers();
+            
+            latticeSize = other.latticeSize;
+            lattice = createBuffer<GoldsteinHarmonic>(latticeSize);
+            latticeByRatio = createBuffer<GoldsteinHarmonic>(latticeSize);
+            
+            copy(other.lattice, other.lattice + latticeSize, lattice);
+            copy(other.latticeByRatio, other.latticeByRatio + latticeSize, latticeByRatio);
+            
+            resetState();
+        }
+    }
+
     Harmonicity::~Harmonicity() {
         freeMemory();
     }
@@ -138,79 +182,117 @@ namespace Sirens {
             ceil(max_hz * double(fftSize) / double(sampleRate))
         );
         
-        int vector_size = maxFrequencyIndex - minFrequencyIndex;
+        // Below about 7 kHz, max_hz is past the end of the spectrum. Peak
+        // interpolation reads the bin after each peak, so keep the last one
+        // out of the search.
+        maxFrequencyIndex = minimum(maxFrequencyIndex, spectrumSize - 1);
+        minFrequencyIndex = minimum(minFrequencyIndex, maxFrequencyIndex);
         
         // Parame ters.
         searchRegionLength2 = (searchRegionLength - 1) / 2;
         
         nMax = 10;
-        filterOldValue = 0;
         kVar = 0.01 / sqrt(2.0);
         
+        createBuffers();
+        resetState();
+        
+        // Goldstein lattice, in the same (n1, n2) order as the search.
+        latticeSize = nMax * (nMax - 1) / 2;
+        lattice = createBuffer<GoldsteinHarmonic>(latticeSize);
+        latticeByRatio = createBuffer<GoldsteinHarmonic>(latticeSize);
+        
+        int harmonic = 0;
+        
+        for (int n1 = 1; n1 < nMax; n1++) {
+            for (int n2 = n1 + 1; n2 <= nMax; n2++) {
+                lattice[harmonic].n1 = n1;
+                lattice[harmonic].n2 = n2;
+                lattice[harmonic].ratio = double(n1) / double(n2);
+                lattice[harmonic].logWeight = log(double(n1)) - log(double(n2));
+                
+                latticeByRatio[harmonic] = lattice[harmonic];
+                harmonic ++;
+            }
+        }
+        
+        sort(latticeByRatio, latticeByRatio + latticeSize, SortRatios);
+    }
+    
+    void Harmonicity::createBuffers() {
+        int vector_size = maxFrequencyIndex - minFrequencyIndex;
+        
         // Vectors for peaks, magnitudes, and indices.
         rawIndices.size = 0;
         rawMagnitudes.size = 0;
         accIndices.size = 0;
         peakList.size = 0;
         
-        rawIndices.values = new int[vector_size];
-        rawMagnitudes.values = new double[vector_size];
-        accIndices.values = new int[vector_size];
-        peakList.values = new Peak[vector_size];
+        rawIndices.values = createBuffer<int>(vector_size);
+        windowIndices = createBuffer<int>(vector_size);
+        rawMagnitudes.values = createBuffer<double>(vector_size);
+        accIndices.values = createBuffer<int>(vector_size);
+        peakList.values = createBuffer<Peak>(vector_size);
+    }
+    
+    void Harmonicity::resetState() {
+        filterOldValue = 0;
+        pitch = 0;
     }
     
     void Harmonicity::freeMemory() {
-        if (rawIndices.values)
-            delete [] rawIndices.values;
-        
-        if (rawMagnitudes.values)
-            delete [] rawMagnitudes.values;
-        
-        if (accIndices.values)
-            delete [] accIndices.values;
-        
-        if (peakList.values)
-            delete [] peakList.values;
+        freeBuffer(rawIndices.values);
+        freeBuffer(rawMagnitudes.values);
+        freeBuffer(accIndices.values);
+        freeBuffer(windowIndices);
+        freeBuffer(peakList.values);
+        freeBuffer(lattice);
+        freeBuffer(latticeByRatio);
     }
     
-    void Harmonicity::pickPeaks() {     
+    double Harmonicity::findRawPeaks() {
+        // The spectrum is refilled completely every frame, so its data is
+        // contiguous and in order.
+        double* spectrum = input->getData();
+        
         // Search through all bins, chopping off the beginning and end, so we
-        // can slide a searchRegionLength window across the spectrum.
-        for(int k = minFrequencyIndex + searchRegionLength2; k < maxFrequencyIndex - searchRegionLength2; k++) {
-            // Find the maximum amplitude in the search region surrounding the
-            // current frequency.
-            double maxel = 0;
-            
-            for (int i = k - searchRegionLength2; i <= k + searchRegionLength2; i++) {
-                if (maxel < input->getValue(i))
-                    maxel = input->getValue(i);
-            }
-            
+        // can slide a searchRegionLength window across the spectrum. A bin is
+        // a raw peak if it is the maximum of the window centered on it.
+        SlidingMaximum window(windowIndices, minFrequencyIndex, searchRegionLength2);
+        
+        double max_peak_mag = 0;
+        
+        for (int i = minFrequencyIndex; i < maxFrequencyIndex; i++) {
             // Save the bin with the maximum amplitude in the search region.
-            if (input->getValue(k) >= maxel) {
+            if (window.add(spectrum, i)) {
+                int k = i - searchRegionLength2;
+                
                 rawIndices.values[rawIndices.size] = k;
                 rawIndices.size ++;
-                rawMagnitudes.values[rawMagnitudes.size] = input->getValue(k);
+                rawMagnitudes.values[rawMagnitudes.size] = spectrum[k];
                 rawMagnitudes.size ++;
+                
+                // Find the maximum amplitude from the spectrum.
+                if (max_peak_mag < spectrum[k])
+                    max_peak_mag = spectrum[k];
             }
         }
         
-        // Find the maximum amplitude from the spectrum.
-        double max_peak_mag = 0;
+        return max_peak_mag;
+    }
+    
+    void Harmonicity::pickPeaks(double max_peak_mag) {
+        double* spectrum = input->getData();
         
-        for (int i = 0; i < rawMagnitudes.size; i++) {
-            if (max_peak_mag < rawMagnitudes.values[i])
-                max_peak_mag = rawMagnitudes.values[i];
-        }
-                
         // Accept only frequency bins where the amplitudes threshold is greater
         // than the absolute threshold and threshold relative to the maximum
-        // amplitude.
+        // amplitude. Both tests collapse into one cutoff, and the loop is
+        // written without branches so that it can be vectorized.
+        double cutoff = maximum(threshold * max_peak_mag, absThreshold);
+        
         for (int k = 0; k < rawIndices.size; k++) {
-            if ((input->getValue(rawIndices.values[k]) > threshold * max_peak_mag) && (input->getValue(rawIndices.values[k]) > absThreshold)) {
-                accIndices.values[accIndices.size] = rawIndices.values[k];
-                accIndices.size ++;
-            }
+            accIndices.values[accIndices.size] = rawIndices.values[k];
+            accIndices.size += (rawMagnitudes.values[k] > cutoff);
         }
             
         // Pick peaks from bins that have high amplitudes compared to their
@@ -219,9 +301,9 @@ namespace Sirens {
             int ind = accIndices.values[k];
             
             // Get surrounding amplitudes.
-            double y1 = log(input->getValue(ind - 1));
-            double y2 = log(input->getValue(ind));
-            double y3 = log(input->getValue(ind + 1));
+            double y1 = log(spectrum[ind - 1]);
+            double y2 = log(spectrum[ind]);
+            double y3 = log(spectrum[ind + 1]);
             
             double freq_bin_zero = (y1 - y3) / (2 * (y1 - 2 * y2 + y3));
             
@@ -299,10 +381,108 @@ namespace Sirens {
         return p_f0;
     }
     
+    // Same as goldsteinGaussian, but returns the log probability.
+    double Harmonicity::goldsteinLogGaussian(
+        double x1, 
+        double x2, 
+        int n1, 
+        int n2, 
+        double f0, 
+        double k
+    ) {
+        double sigma_component1 = k * f0 * n1;
+        double sigma_component2 = k * f0 * n2;
+        
+        double z1 = (x1 - f0 * n1) / sigma_component1;
+        double z2 = (x2 - f0 * n2) / sigma_component2;
+        
+        return -log(2.0 * PI * sigma_component1 * sigma_component2) - 
+            0.5 * (z1 * z1 + z2 * z2);
+    }
+    
+    // Least-squares fundamental for peaks f1 and f2 as harmonics n1 and n2.
+    double Harmonicity::goldsteinFrequency(
+        double f1, 
+        double f2, 
+        int n1, 
+        int n2
+    ) {
+        double f1_rat = f1 / double(n1);
+        double f2_rat = f2 / double(n2);
+        
+        return ((f1_rat * f1_rat) + (f2_rat * f2_rat)) / (f1_rat + f2_rat);
+    }
+    
+    /*
+        Maximum likelihood pitch over every peak pair and harmonic number pair.
+        
+        With rho = (f2 / f1) * (n1 / n2), the log likelihood of a candidate
+        simplifies to
+            -log(2 pi k^2) - 2 log(f1) + log(n1) - log(n2) - 2 log(g(rho))
+                - (rho - 1)^2 / (2 k^2 (1 + rho^2)),
+        where g(rho) = (1 + rho^2) / (1 + rho) >= 2 (sqrt(2) - 1). This gives a
+        cheap upper bound for every candidate. Candidates are pruned if their
+        bound falls below the likelihood already achieved by the candidate
+        whose ratio best matches the peak pair, and only the survivors are
+        evaluated exactly, in the original order. Pruned candidates are
+        strictly less likely than the maximum, so the result is identical to
+        an exhaustive search.
+    */
     void Harmonicity::goldsteinCalc() {
-        int p1, p2, n1, n2;
-        double p0, f0, f1, f2, f1_rat, f2_rat, p_temp, f_temp;
+        int p1, p2, c, n1, n2;
+        double p0, f0, f1, f2, p_temp, f_temp;
+        
+        double k2 = kVar * kVar;
+        double lambda = 1.0 / (2.0 * k2);
+        double log_constant = -log(2.0 * PI * k2) - 
+            2.0 * log(2.0 * (sqrt(2.0) - 1.0));
+        
+        // Slack for rounding error in the log domain.
+        double margin = 0.000001;
+        
+        // 1. Lower bound on the best log likelihood: for each peak pair,
+        // evaluate the lattice ratios on either side of f1 / f2.
+        double best_log = -numeric_limits<double>::infinity();
+        
+        for (p1 = 0; p1 < peakList.size - 1; p1++) {
+            for (p2 = p1 + 1; p2 < peakList.size;  p2++) {
+                f1 = peakList.values[p1].frequency;
+                f2 = peakList.values[p2].frequency;
+                
+                GoldsteinHarmonic target;
+                target.ratio = f1 / f2;
+                
+                c = lower_bound(
+                    latticeByRatio, 
+                    latticeByRatio + latticeSize, 
+                    target, 
+                    SortRatios
+                ) - latticeByRatio;
+                
+                for (int i = maximum(c - 1, 0); i <= minimum(c, latticeSize - 1); i++) {
+                    n1 = latticeByRatio[i].n1;
+                    n2 = latticeByRatio[i].n2;
+                    
+                    best_log = maximum(best_log, goldsteinLogGaussian(
+                        f1, 
+                        f2, 
+                        n1, 
+                        n2, 
+                        goldsteinFrequency(f1, f2, n1, n2), 
+                        kVar
+                    ));
+                }
+            }
+        }
+        
+        // Near underflow, rounding no longer preserves order, so search
+        // exhaustively.
+        double cutoff = best_log - margin;
+        
+        if (!(best_log > log(numeric_limits<double>::min()) + 1.0))
+            cutoff = -numeric_limits<double>::infinity();
         
+        // 2. Exact search over candidates whose bound reaches the cutoff.
         p0 = 0;
         f0 = peakList.values[0].frequency;
         
@@ -311,27 +491,40 @@ namespace Sirens {
                 f1 = peakList.values[p1].frequency;
                 f2 = peakList.values[p2].frequency;
                 
-                for (n1 = 0; n1 < nMax - 1; n1++) {
-                    for (n2 = n1 + 1; n2 < nMax; n2++) {
-                        f1_rat = f1 / (n1 + 1.0);
-                        f2_rat = f2 / (n2 + 1.0);
-                        f_temp = (
-                            (f1_rat * f1_rat) + (f2_rat * f2_rat)
-                        ) / (f1_rat + f2_rat);
-
-                        p_temp = goldsteinGaussian(
-                            f1, 
-                            f2, 
-                            n1 + 1, 
-                            n2 + 1, 
-                            f_temp, 
-                            kVar
-                        );
-                        
-                        if ((p_temp > p0)) {
-                            f0 = f_temp;
-                            p0 = p_temp;
-                        }
+                double pair_ratio = f2 / f1;
+                double pair_bound = log_constant - 2.0 * log(f1) - cutoff;
+                
+                for (c = 0; c < latticeSize; c++) {
+                    // Prune if lambda * h(rho) > bound, where
+                    // h(rho) = (rho - 1)^2 / (1 + rho^2). Comparisons against
+                    // NaN fail, so degenerate peaks are never pruned.
+                    double bound = pair_bound + lattice[c].logWeight;
+                    double rho = pair_ratio * lattice[c].ratio;
+                    double deviation = rho - 1.0;
+                    
+                    if (
+                        bound < 0 || 
+                        lambda * deviation * deviation > bound * (1.0 + rho * rho)
+                    )
+                        continue;
+                    
+                    n1 = lattice[c].n1;
+                    n2 = lattice[c].n2;
+                    
+                    f_temp = goldsteinFrequency(f1, f2, n1, n2);
+                    
+                    p_temp = goldsteinGaussian(
+                        f1, 
+                        f2, 
+                        n1, 
+                        n2, 
+                        f_temp, 
+                        kVar
+                    );
+                    
+                    if ((p_temp > p0)) {
+                        f0 = f_temp;
+                        p0 = p_temp;
                     }
                 }
             }
@@ -342,8 +535,41 @@ namespace Sirens {
     }
     
     void Harmonicity::performCalculation() {
-        pickPeaks();
+        pickPeaks(findRawPeaks());
+        calculatePitch();
+    }
+    
+    bool Harmonicity::configureStatistics(SpectralStatistics* statistics) {
+        statistics->requestPeaks(
+            minFrequencyIndex, 
+            maxFrequencyIndex, 
+            searchRegionLength2
+        );
+        
+        return true;
+    }
+    
+    bool Harmonicity::performFusedCalculation(SpectralStatistics* statistics) {
+        if (!statistics->hasPeaks(minFrequencyIndex, maxFrequencyIndex, searchRegionLength2))
+            return false;
+        
+        int* peak_indices = statistics->getPeakIndices();
+        double* peak_magnitudes = statistics->getPeakMagnitudes();
+        
+        rawIndices.size = rawMagnitudes.size = statistics->getPeakCount();
+        
+        for (int i = 0; i < rawIndices.size; i++) {
+            rawIndices.values[i] = peak_indices[i];
+            rawMagnitudes.values[i] = peak_magnitudes[i];
+        }
         
+        pickPeaks(statistics->getMaxPeakMagnitude());
+        calculatePitch();
+        
+        return true;
+    }
+    
+    void Harmonicity::calculatePitch() {
         if (peakList.size == 1) {
             pitch = peakList.values[0].frequency;
             value = 0;
@@ -367,4 +593,11 @@ namespace Sirens {
     bool SortFrequencies(const Peak& peak1, const Peak& peak2) {
         return peak1.frequency < peak2.frequency;
     }
+    
+    bool SortRatios(
+        const GoldsteinHarmonic& harmonic1, 
+        const GoldsteinHarmonic& harmonic2
+    ) {
+        return harmonic1.ratio < harmonic2.ratio;
+    }
 }
@@ -43,6 +43,18 @@ namespace Sirens {
         int size;
     };
     
+    // One (n1, n2) harmonic number pair of the Goldstein pitch lattice.
+    struct GoldsteinHarmonic {
+        int n1, n2;
+        
+        // n1 / n2. Pairs with the same ratio explain a peak pair equally well.
+        double ratio;
+        
+        // log(n1) - log(n2), the part of the log likelihood's constant term
+        // that depends only on the harmonic numbers.
+        double logWeight;
+    };
+    
     class Harmonicity : public Feature {
     private:        
         double threshold, absThreshold;
@@ -60,6 +72,9 @@ namespace Sirens {
         HarmonicityDoubleVector rawMagnitudes;
         HarmonicityPeakVector peakList;
         
+        // Monotonic deque of bin indices for the sliding-window maximum.
+        int* windowIndices;
+        
         Peak tempPeak;
         
         double fftMax;
@@ -67,7 +82,19 @@ namespace Sirens {
         double lpfCoefficient;
         double filterOldValue;
 
-        void pickPeaks();
+        // Peak picking is split in two so that the fused spectral pass can
+        // supply the raw peaks: findRawPeaks fills rawIndices/rawMagnitudes
+        // and returns their maximum amplitude, and pickPeaks thresholds and
+        // refines them into peakList.
+        double findRawPeaks();
+        void pickPeaks(double max_peak_mag);
+        void calculatePitch();
+        
+        // Goldstein lattice of harmonic number pairs, both in the original
+        // search order and sorted by ratio.
+        GoldsteinHarmonic* lattice;
+        GoldsteinHarmonic* latticeByRatio;
+        int latticeSize;
         
         double goldsteinGaussian(
             double x1, 
@@ -77,19 +104,35 @@ namespace Sirens {
             double f0, 
             double k
         );
+        
+        double goldsteinLogGaussian(
+            double x1, 
+            double x2, 
+            int n1, 
+            int n2, 
+            double f0, 
+            double k
+        );
+        
+        double goldsteinFrequency(double f1, double f2, int n1, int n2);
 
         void goldsteinCalc();
         
         void freeMemory();
         void initialize();
+        
+        // Allocates the peak picking buffers.
+        void createBuffers();
+        virtual void resetState();
 
     public:
         Harmonicity(
-            int history_size = 1, 
+            int history_size = 0, 
             int spectrum_size = 1024, 
             int sample_rate = 44100
         );
         
+        Harmonicity(const Harmonicity& other);
         ~Harmonicity();
         
         void setSpectrumSize(int spectrum_size);
@@ -109,12 +152,20 @@ namespace Sirens {
         double getLPFCoefficient();
         
         virtual void performCalculation();
+        virtual Feature* clone() {return new Harmonicity(*this);}
+        
+        virtual bool configureStatistics(SpectralStatistics* statistics);
+        virtual bool performFusedCalculation(SpectralStatistics* statistics);
         virtual const char* toString();
     };
     
     // Callbacks for sorting peaks.
     bool SortAmplitudes(const Peak& peak1, const Peak& peak2);
     bool SortFrequencies(const Peak& peak1, const Peak& peak2);
+    bool SortRatios(
+        const GoldsteinHarmonic& harmonic1, 
+        const GoldsteinHarmonic& harmonic2
+    );
 }
 
 #endif
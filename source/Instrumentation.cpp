@@ -0,0 +1,338 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Instrumentation.h"
+
+#include <map>
+#include <set>
+#include <fstream>
+#include <iomanip>
+#include <time.h>
+using namespace std;
+
+namespace Sirens {
+    // One complete ("X") trace event.
+    struct TraceEvent {
+        const char* name;
+        double start, end;
+        unsigned long thread;
+    };
+    
+    // Timings, counts and trace events of one thread, keyed by name pointer
+    // (see Instrumentation::intern). Its mutex is only contended while stats
+    // are read or reset, so timers on different threads don't contend.
+    struct ThreadRecord {
+        pthread_mutex_t mutex;
+        map<const char*, InstrumentationStats> stats;
+        vector<TraceEvent> traceEvents;
+        bool tracing;
+        unsigned long thread;
+    };
+    
+    // Shared by every thread, guarded by mutex: totals of threads that have
+    // exited, the records of live threads and interned names.
+    static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    static map<string, InstrumentationStats> stats;
+    static vector<TraceEvent> traceEvents;
+    static set<ThreadRecord*> records;
+    static set<string> names;
+    static bool tracing = false;
+    static double traceStart = Instrumentation::now();
+    
+    static pthread_key_t record_key;
+    static pthread_once_t record_key_once = PTHREAD_ONCE_INIT;
+    
+    bool Instrumentation::isEnabled() {
+#ifdef SIRENS_INSTRUMENTATION
+        return true;
+#else
+        return false;
+#endif
+    }
+    
+    // Monotonic, so durations can't go negative when the wall clock is set.
+    double Instrumentation::now() {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        
+        return time.tv_sec + time.tv_nsec / 1000000000.0;
+    }
+    
+    const char* Instrumentation::intern(const string& name) {
+        pthread_mutex_lock(&mutex);
+        
+        const char* interned = names.insert(name).first->c_str();
+        
+        pthread_mutex_unlock(&mutex);
+        
+        return interned;
+    }
+    
+    static void merge_stats(InstrumentationStats& into, const InstrumentationStats& from) {
+        if (from.calls > 0) {
+            if (into.calls == 0 || from.minSeconds < into.minSeconds)
+                into.minSeconds = from.minSeconds;
+            
+            if (into.calls == 0 || from.maxSeconds > into.maxSeconds)
+                into.maxSeconds = from.maxSeconds;
+        }
+        
+        into.calls += from.calls;
+        into.seconds += from.seconds;
+        into.count += from.count;
+    }
+    
+    static InstrumentationStats new_stats(const string& name) {
+        InstrumentationStats created;
+        created.name = name;
+        created.calls = 0;
+        created.seconds = created.minSeconds = created.maxSeconds = 0;
+        created.count = 0;
+        
+        return created;
+    }
+    
+    // Adds a thread's stats to totals, merging names with the same text.
+    // Callers hold the record's mutex or own the record.
+    static void merge_record(map<string, InstrumentationStats>& totals, ThreadRecord* record) {
+        for (
+            map<const char*, InstrumentationStats>::iterator item = record->stats.begin();
+            item != record->stats.end();
+            item++
+        ) {
+            map<string, InstrumentationStats>::iterator total = totals.find(item->second.name);
+            
+            if (total == totals.end())
+                total = totals.insert(make_pair(item->second.name, new_stats(item->second.name))).first;
+            
+            merge_stats(total->second, item->second);
+        }
+    }
+    
+    // Called when a thread exits: its stats go into the totals.
+    static void release_record(void* data) {
+        ThreadRecord* record = (ThreadRecord*)data;
+        
+        pthread_mutex_lock(&mutex);
+        
+        merge_record(stats, record);
+        traceEvents.insert(traceEvents.end(), record->traceEvents.begin(), record->traceEvents.end());
+        records.erase(record);
+        
+        pthread_mutex_unlock(&mutex);
+        
+        pthread_mutex_destroy(&record->mutex);
+        delete record;
+    }
+    
+    static void create_record_key() {
+        pthread_key_create(&record_key, release_record);
+    }
+    
+    static ThreadRecord* get_record() {
+        pthread_once(&record_key_once, create_record_key);
+        
+        ThreadRecord* record = (ThreadRecord*)pthread_getspecific(record_key);
+        
+        if (record == NULL) {
+            record = new ThreadRecord();
+            pthread_mutex_init(&record->mutex, NULL);
+            record->thread = (unsigned long)pthread_self();
+            
+            pthread_mutex_lock(&mutex);
+            
+            record->tracing = tracing;
+            records.insert(record);
+            
+            pthread_mutex_unlock(&mutex);
+            
+            pthread_setspecific(record_key, record);
+        }
+        
+        return record;
+    }
+    
+    static InstrumentationStats& find_stats(ThreadRecord* record, const char* name) {
+        map<const char*, InstrumentationStats>::iterator item = record->stats.find(name);
+        
+        if (item == record->stats.end())
+            item = record->stats.insert(make_pair(name, new_stats(name))).first;
+        
+        return item->second;
+    }
+    
+    void Instrumentation::addTiming(const char* name, double start, double end) {
+        double seconds = end - start;
+        
+        ThreadRecord* record = get_record();
+        
+        pthread_mutex_lock(&record->mutex);
+        
+        InstrumentationStats& item = find_stats(record, name);
+        
+        if (item.calls == 0 || seconds < item.minSeconds)
+            item.minSeconds = seconds;
+        
+        if (item.calls == 0 || seconds > item.maxSeconds)
+            item.maxSeconds = seconds;
+        
+        item.calls ++;
+        item.seconds += seconds;
+        
+        if (record->tracing) {
+            TraceEvent event;
+            event.name = name;
+            event.start = start;
+            event.end = end;
+            event.thread = record->thread;
+            
+            record->traceEvents.push_back(event);
+        }
+        
+        pthread_mutex_unlock(&record->mutex);
+    }
+    
+    void Instrumentation::addCount(const char* name, long amount) {
+        ThreadRecord* record = get_record();
+        
+        pthread_mutex_lock(&record->mutex);
+        
+        find_stats(record, name).count += amount;
+        
+        pthread_mutex_unlock(&record->mutex);
+    }
+    
+    vector<InstrumentationStats> Instrumentation::getStats() {
+        vector<InstrumentationStats> all_stats;
+        
+        pthread_mutex_lock(&mutex);
+        
+        map<string, InstrumentationStats> totals = stats;
+        
+        for (set<ThreadRecord*>::iterator record = records.begin(); record != records.end(); record++) {
+            pthread_mutex_lock(&(*record)->mutex);
+            merge_record(totals, *record);
+            pthread_mutex_unlock(&(*record)->mutex);
+        }
+        
+        pthread_mutex_unlock(&mutex);
+        
+        for (
+            map<string, InstrumentationStats>::iterator item = totals.begin();
+            item != totals.end();
+            item++
+        )
+            all_stats.push_back(item->second);
+        
+        return all_stats;
+    }
+    
+    void Instrumentation::reset() {
+        pthread_mutex_lock(&mutex);
+        
+        stats.clear();
+        traceEvents.clear();
+        
+        for (set<ThreadRecord*>::iterator record = records.begin(); record != records.end(); record++) {
+            pthread_mutex_lock(&(*record)->mutex);
+            (*record)->stats.clear();
+            (*record)->traceEvents.clear();
+            pthread_mutex_unlock(&(*record)->mutex);
+        }
+        
+        traceStart = now();
+        
+        pthread_mutex_unlock(&mutex);
+    }
+    
+    void Instrumentation::setTracing(bool tracing_in) {
+        pthread_mutex_lock(&mutex);
+        
+        tracing = tracing_in;
+        
+        for (set<ThreadRecord*>::iterator record = records.begin(); record != records.end(); record++) {
+            pthread_mutex_lock(&(*record)->mutex);
+            (*record)->tracing = tracing_in;
+            pthread_mutex_unlock(&(*record)->mutex);
+        }
+        
+        pthread_mutex_unlock(&mutex);
+    }
+    
+    bool Instrumentation::getTracing() {
+        pthread_mutex_lock(&mutex);
+        
+        bool tracing_out = tracing;
+        
+        pthread_mutex_unlock(&mutex);
+        
+        return tracing_out;
+    }
+    
+    static string escape_json(const string& text) {
+        string escaped;
+        
+        for (unsigned int i = 0; i < text.size(); i++) {
+            if (text[i] == '"' || text[i] == '\\')
+                escaped += '\\';
+            
+            escaped += text[i];
+        }
+        
+        return escaped;
+    }
+    
+    void Instrumentation::saveTrace(string path) {
+        pthread_mutex_lock(&mutex);
+        
+        vector<TraceEvent> events = traceEvents;
+        
+        for (set<ThreadRecord*>::iterator record = records.begin(); record != records.end(); record++) {
+            pthread_mutex_lock(&(*record)->mutex);
+            events.insert(events.end(), (*record)->traceEvents.begin(), (*record)->traceEvents.end());
+            pthread_mutex_unlock(&(*record)->mutex);
+        }
+        
+        // Threads are numbered in order of appearance.
+        map<unsigned long, int> thread_ids;
+        
+        ofstream trace(path.c_str());
+        trace << fixed << setprecision(3);
+        trace << "{\"traceEvents\": [" << endl;
+        
+        for (unsigned int i = 0; i < events.size(); i++) {
+            TraceEvent& event = events[i];
+            
+            if (thread_ids.find(event.thread) == thread_ids.end()) {
+                int thread_id = thread_ids.size();
+                thread_ids[event.thread] = thread_id;
+            }
+            
+            trace << "  {\"name\": \"" << escape_json(event.name) << "\", " <<
+                "\"ph\": \"X\", \"pid\": 1, \"tid\": " << thread_ids[event.thread] <<
+                ", \"ts\": " << (event.start - traceStart) * 1000000.0 <<
+                ", \"dur\": " << (event.end - event.start) * 1000000.0 << "}" <<
+                ((i + 1 < events.size()) ? "," : "") << endl;
+        }
+        
+        trace << "]}" << endl;
+        
+        pthread_mutex_unlock(&mutex);
+    }
+}
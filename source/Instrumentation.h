@@ -0,0 +1,126 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_INSTRUMENTATION_H
+#define SIRENS_INSTRUMENTATION_H
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+/*
+    Instrumentation - scoped timers and counters for the library's hot paths:
+        feature extraction (per file, per stage and per feature),
+        segmentation and comparison.
+    
+    Timers and counters are only compiled in when the library is built with
+    SIRENS_INSTRUMENTATION defined (`scons --instrument`). Otherwise the
+    SIRENS_TIMER and SIRENS_COUNT macros expand to nothing and getStats()
+    returns an empty list.
+    
+    Names are C strings that must outlive the stats: literals, or names
+    built at run time and passed through Instrumentation::intern once.
+    Each thread accumulates its own timings, merged when stats are read or
+    the thread exits, so a timer costs two clock reads and an uncontended
+    lock.
+    
+    Usage:
+        void Segmenter::decodeFrames(int begin, int end) {
+            SIRENS_TIMER("segment:viterbi");
+            ...
+        }
+        
+        vector<InstrumentationStats> stats = Instrumentation::getStats();
+        
+        // Optionally record every timed scope and save it in Chrome's
+        // trace event format, for chrome://tracing or Perfetto.
+        Instrumentation::setTracing(true);
+        ...
+        Instrumentation::saveTrace("trace.json");
+*/
+
+namespace Sirens {
+    struct InstrumentationStats {
+        string name;
+        
+        // Number of timed calls and their total, minimum and maximum
+        // duration in seconds.
+        long calls;
+        double seconds, minSeconds, maxSeconds;
+        
+        // Sum of all SIRENS_COUNT amounts.
+        long count;
+    };
+    
+    class Instrumentation {
+    public:
+        static bool isEnabled();
+        
+        // Aggregated timings and counts, sorted by name.
+        static vector<InstrumentationStats> getStats();
+        static void reset();
+        
+        // Chrome trace event recording.
+        static void setTracing(bool tracing);
+        static bool getTracing();
+        static void saveTrace(string path);
+        
+        // A copy of name that lives as long as the program, the same pointer
+        // for the same text. Takes a lock, so per-frame scopes should intern
+        // their names once and keep them (see Feature).
+        static const char* intern(const string& name);
+        
+        // Used by the macros.
+        static double now();
+        static void addTiming(const char* name, double start, double end);
+        static void addCount(const char* name, long amount);
+    };
+    
+    class ScopedTimer {
+    private:
+        const char* name;
+        double start;
+        
+    public:
+        ScopedTimer(const char* name_in) {
+            name = name_in;
+            start = Instrumentation::now();
+        }
+        
+        ~ScopedTimer() {
+            Instrumentation::addTiming(name, start, Instrumentation::now());
+        }
+    };
+}
+
+#define SIRENS_CONCATENATE_(a, b) a ## b
+#define SIRENS_CONCATENATE(a, b) SIRENS_CONCATENATE_(a, b)
+
+#ifdef SIRENS_INSTRUMENTATION
+    #define SIRENS_TIMER(name) \
+        Sirens::ScopedTimer SIRENS_CONCATENATE(sirens_timer_, __LINE__)(name)
+    #define SIRENS_COUNT(name, amount) \
+        Sirens::Instrumentation::addCount(name, amount)
+#else
+    #define SIRENS_TIMER(name)
+    #define SIRENS_COUNT(name, amount)
+#endif
+
+#endif
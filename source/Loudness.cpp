@@ -23,10 +23,24 @@
 using namespace std;
 
 #include "math_support.h"
+#include "SampleStatistics.h"
 
 namespace Sirens {
     void Loudness::performCalculation() {
-        double rms_val=signal_rms(input);
+        calculateFromRMS(signal_rms(input));
+    }
+    
+    bool Loudness::configureSampleStatistics(SampleStatistics* statistics) {
+        return true;
+    }
+    
+    bool Loudness::performFusedSampleCalculation(SampleStatistics* statistics) {
+        calculateFromRMS(statistics->getRMS());
+        
+        return true;
+    }
+    
+    void Loudness::calculateFromRMS(double rms_val) {
         if (rms_val)
             value = 20 * log10(rms_val);
         else
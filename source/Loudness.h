@@ -27,11 +27,18 @@ using namespace std;
 
 namespace Sirens {
     class Loudness : public Feature {
+    private:
+        void calculateFromRMS(double rms_val);
+        
     public: 
-        Loudness(int history_size = 1) : Feature(history_size) {}
+        Loudness(int history_size = 0) : Feature(history_size) {}
         
         virtual void performCalculation();
         virtual const char* toString();
+        virtual Feature* clone() {return new Loudness(*this);}
+        
+        virtual bool configureSampleStatistics(SampleStatistics* statistics);
+        virtual bool performFusedSampleCalculation(SampleStatistics* statistics);
     };
 }
 
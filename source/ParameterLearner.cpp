@@ -0,0 +1,408 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ParameterLearner.h"
+
+#include "Segmenter.h"
+#include "Thread.h"
+#include "math_support.h"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <unistd.h>
+using namespace std;
+
+namespace Sirens {
+    // Probabilities never reach 0 or 1, which would rule out mode
+    // transitions altogether.
+    static const double MIN_PROBABILITY = 1e-12;
+    
+    // Points in the grid search, and golden section steps refining it.
+    static const int GRID_POINTS = 15;
+    static const int GOLDEN_STEPS = 30;
+    
+    // Coordinate descent sweeps over the Kalman filter parameters.
+    static const int SWEEPS = 2;
+    
+    ParameterLearner::ParameterLearner(double p_new, double p_off, int beams_in) {
+        pNew = p_new;
+        pOff = p_off;
+        beams = beams_in;
+        
+        factorized = false;
+        learnMeasurementNoise = false;
+        iterations = 10;
+        threads = maximum(int(sysconf(_SC_NPROCESSORS_ONLN)), 1);
+        progressCallback = NULL;
+    }
+    
+    ParameterLearner::~ParameterLearner() {
+    }
+    
+    /*-------------*
+     * Recordings. *
+     *-------------*/
+    
+    void ParameterLearner::addRecording(FeatureSet* feature_set) {
+        recordings.push_back(feature_set);
+    }
+    
+    int ParameterLearner::getRecordingCount() {
+        return recordings.size();
+    }
+    
+    SegmentationParameters* ParameterLearner::getParameters(int feature) {
+        return &parameters[feature];
+    }
+    
+    /*--------*
+     * Tasks. *
+     *--------*/
+    
+    struct LearnerTask {
+        ParameterLearner* learner;
+        void (ParameterLearner::*step)(int);
+    };
+    
+    static void run_step(int index, void* data) {
+        LearnerTask* task = (LearnerTask*)data;
+        
+        (task->learner->*(task->step))(index);
+    }
+    
+    // Run task for every index in [0, count) on up to threads threads.
+    void ParameterLearner::runTasks(void (ParameterLearner::*task)(int), int count) {
+        LearnerTask learner_task;
+        learner_task.learner = this;
+        learner_task.step = task;
+        
+        run_tasks(run_step, &learner_task, count, threads);
+    }
+    
+    /*--------*
+     * Costs. *
+     *--------*/
+    
+    double ParameterLearner::getFeatureCost(int feature, SegmentationParameters& candidate) {
+        candidate.createQTable();
+        
+        double cost = 0;
+        
+        for (int r = 0; r < recordings.size(); r++) {
+            const double* history = histories[r][feature];
+            const vector<int>& feature_modes = featureModes[r][feature];
+            
+            // Filter from the prior, starting off, as Segmenter does.
+            ViterbiDistribution distribution;
+            int previous_mode = 1;
+            
+            for (int i = 0; i < feature_modes.size(); i++) {
+                cost += Segmenter::KalmanLPF(
+                    history[i],
+                    distribution.covariance,
+                    distribution.mean,
+                    candidate.r,
+                    candidate.q[previous_mode - 1][feature_modes[i] - 1],
+                    candidate.alpha
+                );
+                
+                previous_mode = feature_modes[i];
+            }
+        }
+        
+        return cost;
+    }
+    
+    double ParameterLearner::getLagCost(int feature, SegmentationParameters& candidate) {
+        candidate.createFusionLogic();
+        
+        const double* counts = &fusionCounts[feature][0];
+        const double* fusion = &candidate.fusion[0][0][0][0];
+        double cost = 0;
+        
+        for (int i = 0; i < 81; i++) {
+            if (counts[i] > 0)
+                cost -= counts[i] * log(fusion[i]);
+        }
+        
+        return cost;
+    }
+    
+    void ParameterLearner::searchParameter(
+        int feature,
+        SegmentationParameters& candidate,
+        double* value,
+        double low,
+        double high,
+        bool logarithmic,
+        double (ParameterLearner::*cost)(int, SegmentationParameters&)
+    ) {
+        double original = *value;
+        double original_cost = (this->*cost)(feature, candidate);
+        
+        // A starting value outside the range always moves into it.
+        double original_point = logarithmic ? log10(original) : original;
+        
+        if (original_point < low || original_point > high)
+            original_cost = numeric_limits<double>::infinity();
+        
+        high = maximum(low, high);
+        
+        // Best point evaluated, in search coordinates (base 10 exponents for
+        // logarithmic parameters).
+        double best_point = 0;
+        double best_cost = numeric_limits<double>::infinity();
+        
+        // Grid search.
+        double step = (high - low) / (GRID_POINTS - 1);
+        
+        for (int i = 0; i < GRID_POINTS; i++) {
+            double point = low + i * step;
+            *value = logarithmic ? pow(10.0, point) : point;
+            
+            double point_cost = (this->*cost)(feature, candidate);
+            
+            if (point_cost < best_cost) {
+                best_cost = point_cost;
+                best_point = point;
+            }
+        }
+        
+        // Golden section search between the best grid point's neighbors.
+        const double ratio = (sqrt(5.0) - 1) / 2;
+        double a = maximum(best_point - step, low);
+        double b = minimum(best_point + step, high);
+        double points[2], costs[2];
+        
+        for (int i = 0; i < GOLDEN_STEPS; i++) {
+            points[0] = b - ratio * (b - a);
+            points[1] = a + ratio * (b - a);
+            
+            for (int j = 0; j < 2; j++) {
+                *value = logarithmic ? pow(10.0, points[j]) : points[j];
+                costs[j] = (this->*cost)(feature, candidate);
+                
+                if (costs[j] < best_cost) {
+                    best_cost = costs[j];
+                    best_point = points[j];
+                }
+            }
+            
+            if (costs[0] < costs[1])
+                b = points[1];
+            else
+                a = points[0];
+        }
+        
+        // Only move if that is an improvement; parameters with little bearing
+        // on the cost, such as change variances with no changes, stay put.
+        if (best_cost < original_cost)
+            *value = logarithmic ? pow(10.0, best_point) : best_point;
+        else
+            *value = original;
+    }
+    
+    /*--------*
+     * Steps. *
+     *--------*/
+    
+    static void set_parameters(Feature* feature, const SegmentationParameters& parameters) {
+        *feature->parameters() = parameters;
+        
+        feature->parameters()->createFusionLogic();
+        feature->parameters()->createQTable();
+    }
+    
+    void ParameterLearner::segmentRecording(int recording) {
+        vector<Feature*> features = recordings[recording]->getFeatures();
+        
+        for (int f = 0; f < parameters.size(); f++)
+            set_parameters(features[f], parameters[f]);
+        
+        Segmenter segmenter(pNew, pOff, beams);
+        segmenter.setFeatureSet(recordings[recording]);
+        segmenter.setFactorized(factorized);
+        segmenter.segment();
+        
+        modes[recording] = segmenter.getModes();
+        
+        for (int f = 0; f < parameters.size(); f++)
+            featureModes[recording][f] = segmenter.getFeatureModeSequence(f);
+    }
+    
+    // pNew and pOff, from global mode transitions (see
+    // Segmenter::createModeLogic).
+    void ParameterLearner::fitModeTransitions() {
+        double counts[3][3] = {{0}};
+        
+        for (int r = 0; r < modes.size(); r++) {
+            for (int i = 1; i < modes[r].size(); i++)
+                counts[modes[r][i - 1] - 1][modes[r][i] - 1]++;
+        }
+        
+        double from_off_or_on = counts[0][0] + counts[0][1] + 
+            counts[2][0] + counts[2][1] + counts[2][2];
+        
+        if (from_off_or_on > 0) {
+            pNew = (counts[0][1] + counts[2][1]) / from_off_or_on;
+            pNew = maximum(minimum(pNew, 1 - MIN_PROBABILITY), MIN_PROBABILITY);
+        }
+        
+        if (counts[2][0] + counts[2][2] > 0) {
+            pOff = counts[2][0] / (counts[2][0] + counts[2][2]);
+            pOff = maximum(minimum(pOff, 1 - MIN_PROBABILITY), MIN_PROBABILITY);
+        }
+    }
+    
+    void ParameterLearner::fitFeature(int feature) {
+        SegmentationParameters candidate = parameters[feature];
+        
+        // Lag probabilities, from feature mode transitions.
+        vector<double>& counts = fusionCounts[feature];
+        counts.assign(81, 0);
+        
+        for (int r = 0; r < modes.size(); r++) {
+            const vector<int>& global_modes = modes[r];
+            const vector<int>& feature_modes = featureModes[r][feature];
+            
+            for (int i = 1; i < global_modes.size(); i++) {
+                counts[
+                    (global_modes[i - 1] - 1) * 27 + 
+                    (global_modes[i] - 1) * 9 + 
+                    (feature_modes[i - 1] - 1) * 3 + 
+                    (feature_modes[i] - 1)
+                ]++;
+            }
+        }
+        
+        searchParameter(feature, candidate, &candidate.pLagPlus, 0.001, 0.999, false, &ParameterLearner::getLagCost);
+        searchParameter(feature, candidate, &candidate.pLagMinus, 0.001, 0.999, false, &ParameterLearner::getLagCost);
+        
+        // Filter parameters. The change variances are kept at least as large
+        // as the no-change variances (see SegmentationParameters.h);
+        // otherwise a mode can come to stand for a feature being changeable
+        // rather than for its changing, so segments become the stretches
+        // between changes.
+        for (int sweep = 0; sweep < SWEEPS; sweep++) {
+            searchParameter(feature, candidate, &candidate.alpha, 0.001, 0.999, false, &ParameterLearner::getFeatureCost);
+            
+            if (learnMeasurementNoise)
+                searchParameter(feature, candidate, &candidate.r, -12, 1, true, &ParameterLearner::getFeatureCost);
+            
+            double change = log10(minimum(
+                minimum(candidate.cTurnOn, candidate.cTurnOff),
+                candidate.cNewSegment
+            ));
+            
+            searchParameter(feature, candidate, &candidate.cStayOff, -12, change, true, &ParameterLearner::getFeatureCost);
+            searchParameter(feature, candidate, &candidate.cStayOn, -12, change, true, &ParameterLearner::getFeatureCost);
+            
+            double no_change = log10(maximum(candidate.cStayOff, candidate.cStayOn));
+            
+            searchParameter(feature, candidate, &candidate.cTurnOn, no_change, 2, true, &ParameterLearner::getFeatureCost);
+            searchParameter(feature, candidate, &candidate.cTurnOff, no_change, 2, true, &ParameterLearner::getFeatureCost);
+            searchParameter(feature, candidate, &candidate.cNewSegment, no_change, 2, true, &ParameterLearner::getFeatureCost);
+        }
+        
+        parameters[feature] = candidate;
+    }
+    
+    /*-----------*
+     * Learning. *
+     *-----------*/
+    
+    void ParameterLearner::learn() {
+        if (recordings.empty())
+            return;
+        
+        // Start from the first recording's parameters.
+        vector<Feature*> features = recordings[0]->getFeatures();
+        parameters.clear();
+        
+        for (int f = 0; f < features.size(); f++)
+            parameters.push_back(*features[f]->parameters());
+        
+        histories = vector<vector<const double*> >(recordings.size());
+        
+        for (int r = 0; r < recordings.size(); r++) {
+            features = recordings[r]->getFeatures();
+            
+            for (int f = 0; f < parameters.size(); f++)
+                histories[r].push_back(features[f]->getHistory()->getData());
+        }
+        
+        modes = vector<vector<int> >(recordings.size());
+        featureModes = vector<vector<vector<int> > >(
+            recordings.size(),
+            vector<vector<int> >(parameters.size())
+        );
+        fusionCounts = vector<vector<double> >(parameters.size());
+        
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            vector<vector<int> > previous_modes = modes;
+            vector<vector<vector<int> > > previous_feature_modes = featureModes;
+            
+            runTasks(&ParameterLearner::segmentRecording, recordings.size());
+            
+            // The same global and feature modes would give the same
+            // parameters.
+            if (
+                iteration > 0 && 
+                modes == previous_modes && 
+                featureModes == previous_feature_modes
+            )
+                break;
+            
+            fitModeTransitions();
+            runTasks(&ParameterLearner::fitFeature, parameters.size());
+            
+            if (progressCallback != NULL)
+                progressCallback(iteration + 1, iterations);
+        }
+        
+        for (int r = 0; r < recordings.size(); r++) {
+            features = recordings[r]->getFeatures();
+            
+            for (int f = 0; f < parameters.size(); f++)
+                set_parameters(features[f], parameters[f]);
+        }
+    }
+    
+    bool ParameterLearner::saveParameters(string path) {
+        ofstream file(path.c_str());
+        
+        if (!file)
+            return false;
+        
+        file << setprecision(10);
+        file << pNew << "," << pOff << "," << beams << endl;
+        
+        for (int f = 0; f < parameters.size(); f++) {
+            SegmentationParameters& p = parameters[f];
+            
+            file << p.alpha << "," << p.r << "," << p.cStayOff << "," << 
+                p.cTurnOn << "," << p.cTurnOff << "," << p.cNewSegment << "," << 
+                p.cStayOn << "," << p.pLagPlus << "," << p.pLagMinus << endl;
+        }
+        
+        return !file.fail();
+    }
+}
@@ -0,0 +1,162 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_PARAMETERLEARNER_H
+#define SIRENS_PARAMETERLEARNER_H
+
+#include "FeatureSet.h"
+#include "SegmentationParameters.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+/*
+    ParameterLearner - estimates segmentation parameters (see
+        SegmentationParameters.h) from unlabeled feature trajectories, so they
+        needn't be tuned by hand for every new environment.
+    
+    Each recording is a FeatureSet with the same features in the same order.
+    The parameters of the first recording's features, along with pNew and
+    pOff, are the starting point, so rough hand-tuned values (or those for a
+    similar environment) are a good start. Learning alternates two steps,
+    like hard ("Viterbi") EM:
+        1. Segment every recording with the current parameters, keeping the
+            global mode and every feature's mode for each frame.
+        2. Given those modes, set each parameter to the value that makes the
+            trajectories most likely. pNew, pOff, pLagPlus and pLagMinus
+            follow from counting mode transitions. alpha and the five
+            variances (and r, see setLearnMeasurementNoise) are fitted to the
+            Kalman filter's likelihood of each feature's trajectory (the cost
+            in Segmenter::KalmanLPF), one at a time, by a grid search refined
+            with golden section search. The change variances are kept at
+            least as large as the no-change variances.
+    This stops when the global and feature modes stop changing or after the
+    given iterations.
+    Recordings are segmented, and features fitted, on up to getThreads()
+    threads.
+    
+    Every recording's features are left with the learned parameters, so they
+    can be segmented directly afterwards. Like any EM, the result is a local
+    optimum near the starting point; with too few events in the corpus, the
+    change variances and lag probabilities stay close to their starting
+    values.
+*/
+
+namespace Sirens {
+    class ParameterLearner {
+    private:
+        vector<FeatureSet*> recordings;
+        
+        // Current estimates.
+        vector<SegmentationParameters> parameters;
+        double pNew, pOff;
+        int beams;
+        
+        bool factorized;
+        bool learnMeasurementNoise;
+        int iterations;
+        int threads;
+        void(* progressCallback)(int, int);
+        
+        // Feature trajectories, and decoded global and feature modes, for
+        // each recording.
+        vector<vector<const double*> > histories;
+        vector<vector<int> > modes;
+        vector<vector<vector<int> > > featureModes;
+        
+        // Steps, with each recording and feature run as a separate task.
+        void segmentRecording(int recording);
+        void fitFeature(int feature);
+        void fitModeTransitions();
+        
+        void runTasks(void (ParameterLearner::*task)(int), int count);
+        
+        // Feature mode transitions for each global mode transition, counted
+        // over every recording, for each feature ([g'][g][m'][m], flattened).
+        vector<vector<double> > fusionCounts;
+        
+        // Costs (negative log-likelihoods) of a feature's trajectories in
+        // every recording, given their modes, with the given parameters:
+        // of the filtered trajectories, and of the feature mode transitions.
+        double getFeatureCost(int feature, SegmentationParameters& candidate);
+        double getLagCost(int feature, SegmentationParameters& candidate);
+        
+        // Minimize one of the above over a single parameter of candidate.
+        void searchParameter(
+            int feature,
+            SegmentationParameters& candidate,
+            double* value,
+            double low,
+            double high,
+            bool logarithmic,
+            double (ParameterLearner::*cost)(int, SegmentationParameters&)
+        );
+        
+    public:
+        ParameterLearner(double p_new = 0, double p_off = 0, int beams = -1);
+        ~ParameterLearner();
+        
+        // Recordings.
+        void addRecording(FeatureSet* feature_set);
+        int getRecordingCount();
+        
+        // Attributes.
+        void setIterations(int value) {iterations = value;}
+        void setThreads(int value) {threads = value;}
+        void setBeams(int value) {beams = value;}
+        
+        int getIterations() {return iterations;}
+        int getThreads() {return threads;}
+        int getBeams() {return beams;}
+        
+        // Segment with Segmenter::setFactorized, for feature sets too large
+        // for the joint decoder.
+        void setFactorized(bool value) {factorized = value;}
+        bool getFactorized() {return factorized;}
+        
+        // Also fit r, the measurement noise. Off by default: fitted along
+        // with the variances, it tends to collapse towards 0, with the
+        // no-change variances taking up the noise, and segmentation suffers.
+        // Measuring it from a quiet stretch of the recording works better.
+        void setLearnMeasurementNoise(bool value) {learnMeasurementNoise = value;}
+        bool getLearnMeasurementNoise() {return learnMeasurementNoise;}
+        
+        // Called after each iteration with the iteration and the maximum.
+        void setProgressCallback(void(*callback)(int, int)) {
+            progressCallback = callback;
+        }
+        
+        // Learning.
+        void learn();
+        
+        // Learned parameters.
+        double getPNew() {return pNew;}
+        double getPOff() {return pOff;}
+        SegmentationParameters* getParameters(int feature);
+        
+        // Saves the parameters as CSV, as read by examples/segment_csv.cpp:
+        // pNew, pOff and beams on the first line, then alpha, r, cStayOff,
+        // cTurnOn, cTurnOff, cNewSegment, cStayOn, pLagPlus and pLagMinus
+        // for each feature. Returns false if the file couldn't be written.
+        bool saveParameters(string path);
+    };
+}
+
+#endif
@@ -0,0 +1,61 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SampleStatistics.h"
+
+#include <cmath>
+using namespace std;
+
+#include "math_support.h"
+
+namespace Sirens {
+    SampleStatistics::SampleStatistics() {
+        rms = peak = 0;
+        zeroCrossings = 0;
+    }
+    
+    void SampleStatistics::calculate(CircularArray* samples) {
+        int size = samples->getSize();
+        double* data = samples->getData();
+        
+        double sum_of_squares = 0;
+        peak = 0;
+        zeroCrossings = 0;
+        
+        for (int i = 0; i < size; i++) {
+            sum_of_squares += data[i] * data[i];
+            peak = maximum(fabs(data[i]), peak);
+            
+            if (i > 0)
+                zeroCrossings += ((data[i] < 0) != (data[i - 1] < 0));
+        }
+        
+        // Once the array wraps, storage order isn't time order: the pair at
+        // the seam (newest, oldest) isn't adjacent in time, while the last
+        // and first stored samples are.
+        int start = samples->getStart();
+        
+        if (start > 0) {
+            zeroCrossings -= ((data[start] < 0) != (data[start - 1] < 0));
+            zeroCrossings += ((data[0] < 0) != (data[size - 1] < 0));
+        }
+        
+        rms = sqrt(sum_of_squares / (double)size);
+    }
+}
@@ -0,0 +1,53 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_SAMPLESTATISTICS_H
+#define SIRENS_SAMPLESTATISTICS_H
+
+#include "CircularArray.h"
+
+/*
+    SampleStatistics - per-frame time-domain statistics, computed once in a
+        single sweep over the frame and shared by every sample feature that
+        needs them (see Feature::requestSampleStatistics). Used by FeatureSet
+        for all sample features.
+        
+    rms: root mean square of the frame (the same as signal_rms).
+    peak: maximum absolute sample value.
+    zero crossings: number of adjacent sample pairs whose signs differ.
+*/
+
+namespace Sirens {
+    class SampleStatistics {
+    private:
+        double rms, peak;
+        int zeroCrossings;
+        
+    public:
+        SampleStatistics();
+        
+        void calculate(CircularArray* samples);
+        
+        double getRMS() {return rms;}
+        double getPeak() {return peak;}
+        int getZeroCrossings() {return zeroCrossings;}
+    };
+}
+
+#endif
@@ -0,0 +1,283 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SegmentExporter.h"
+
+#include "Exceptions.h"
+#include "Instrumentation.h"
+#include "Thread.h"
+#include "math_support.h"
+#include "string_support.h"
+
+#include <algorithm>
+using namespace std;
+
+#include <unistd.h>
+
+namespace Sirens {
+    // Orders segments by their first sample.
+    class SegmentOrder {
+    public:
+        const vector<long>* begins;
+        
+        bool operator()(int a, int b) const {
+            return (*begins)[a] < (*begins)[b];
+        }
+    };
+    
+    SegmentExporter::SegmentExporter(Sound* sound_in) {
+        sound = sound_in;
+        blockSize = 1 << 18;
+        threads = maximum(int(sysconf(_SC_NPROCESSORS_ONLN)), 1);
+        
+        file = NULL;
+        encodingBlock = 0;
+        blockBegin = blockEnd = 0;
+        nextBegin = nextEnd = 0;
+    }
+    
+    SegmentExporter::~SegmentExporter() {
+    }
+    
+    /*-----------*
+     * Segments. *
+     *-----------*/
+    
+    void SegmentExporter::addSegment(int start_frame, int end_frame, string path) {
+        startFrames.push_back(start_frame);
+        endFrames.push_back(end_frame);
+        paths.push_back(path);
+    }
+    
+    void SegmentExporter::addSegments(vector<vector<int> > segments, string path_prefix) {
+        for (int i = 0; i < segments.size(); i++)
+            addSegment(segments[i][0], segments[i][1], path_prefix + double_to_string(i) + ".wav");
+    }
+    
+    int SegmentExporter::getSegmentCount() {
+        return paths.size();
+    }
+    
+    void SegmentExporter::clearSegments() {
+        startFrames.clear();
+        endFrames.clear();
+        paths.clear();
+    }
+    
+    /*---------*
+     * Export. *
+     *---------*/
+    
+    // Task 0 reads the next block, if there is one; the rest each encode a
+    // segment's part of the current block.
+    void SegmentExporter::runBlockTask(int task) {
+        try {
+            if (task == 0) {
+                if (nextEnd > nextBegin) {
+                    StkFrames& block = blocks[1 - encodingBlock];
+                    block.resize(nextEnd - nextBegin, file->channels());
+                    
+                    file->read(block, nextBegin, false);
+                }
+            } else {
+                int segment = taskSegments[task - 1];
+                StkFrames& block = blocks[encodingBlock];
+                
+                long first = maximum(begins[segment], blockBegin);
+                long last = minimum(ends[segment], blockEnd);
+                
+                writers[segment]->write(
+                    &block[(first - blockBegin) * block.channels()],
+                    last - first,
+                    false
+                );
+            }
+        } catch (StkError&) {
+            taskFailed[task] = true;
+        }
+    }
+    
+    void SegmentExporter::runTask(int task, void* exporter) {
+        ((SegmentExporter*)exporter)->runBlockTask(task);
+    }
+    
+    void SegmentExporter::run() {
+        SIRENS_TIMER("export");
+        
+        if (sound->getPath().empty())
+            throw SoundNotLoadedException();
+        
+        int count = paths.size();
+        
+        try {
+            file = new FileRead(sound->getPath());
+        } catch (StkError&) {
+            file = NULL;
+            throw SegmentExportException();
+        }
+        
+        // Segment sample ranges, with the sound's frame and hop sizes.
+        int sample_rate = file->fileRate();
+        long samples_per_frame = int(sound->getFrameLength() * double(sample_rate));
+        long samples_per_hop = int(sound->getHopLength() * double(sample_rate));
+        long file_size = file->fileSize();
+        
+        begins = vector<long>(count);
+        ends = vector<long>(count);
+        
+        for (int i = 0; i < count; i++) {
+            begins[i] = minimum(maximum(samples_per_hop * startFrames[i], 0L), file_size);
+            ends[i] = samples_per_hop * (endFrames[i] - 1) + samples_per_frame;
+            ends[i] = minimum(maximum(ends[i], begins[i]), file_size);
+        }
+        
+        vector<int> order(count);
+        
+        for (int i = 0; i < count; i++)
+            order[i] = i;
+        
+        SegmentOrder segment_order;
+        segment_order.begins = &begins;
+        stable_sort(order.begin(), order.end(), segment_order);
+        
+        // Blocks covering the union of the ranges, none longer than
+        // blockSize.
+        vector<long> block_begins, block_ends;
+        
+        for (int i = 0; i < count; ) {
+            long begin = begins[order[i]];
+            long end = ends[order[i]];
+            
+            for (i++; i < count && begins[order[i]] <= end; i++)
+                end = maximum(end, ends[order[i]]);
+            
+            for (long position = begin; position < end; position += blockSize) {
+                block_begins.push_back(position);
+                block_ends.push_back(minimum(position + long(blockSize), end));
+            }
+        }
+        
+        writers = vector<FileWrite*>(count, (FileWrite*)NULL);
+        bool failed = false;
+        
+        // Segments open from their first block to their last.
+        vector<int> open_segments;
+        int next_segment = 0;
+        
+        nextBegin = nextEnd = 0;
+        
+        if (!block_begins.empty()) {
+            nextBegin = block_begins[0];
+            nextEnd = block_ends[0];
+        }
+        
+        encodingBlock = 1;
+        taskFailed = vector<char>(1, false);
+        runBlockTask(0);
+        failed = taskFailed[0];
+        
+        for (int b = 0; b < block_begins.size() && !failed; b++) {
+            encodingBlock = 1 - encodingBlock;
+            blockBegin = block_begins[b];
+            blockEnd = block_ends[b];
+            
+            if (b + 1 < block_begins.size()) {
+                nextBegin = block_begins[b + 1];
+                nextEnd = block_ends[b + 1];
+            } else
+                nextBegin = nextEnd = 0;
+            
+            // Open the segments that start in this block, on this thread.
+            try {
+                for (; next_segment < count && begins[order[next_segment]] < blockEnd; next_segment++) {
+                    int segment = order[next_segment];
+                    
+                    writers[segment] = new FileWrite(
+                        paths[segment],
+                        file->channels(),
+                        file->format(),
+                        file->fileRate()
+                    );
+                    
+                    if (ends[segment] > begins[segment])
+                        open_segments.push_back(segment);
+                    else {
+                        delete writers[segment];
+                        writers[segment] = NULL;
+                    }
+                }
+            } catch (StkError&) {
+                failed = true;
+                break;
+            }
+            
+            taskSegments = open_segments;
+            taskFailed = vector<char>(taskSegments.size() + 1, false);
+            
+            run_tasks(runTask, this, taskSegments.size() + 1, threads);
+            
+            SIRENS_COUNT("export:frames", blockEnd - blockBegin);
+            
+            for (int t = 0; t < taskFailed.size(); t++)
+                failed = failed || taskFailed[t];
+            
+            // Close the segments that end in this block.
+            vector<int> still_open;
+            
+            for (int i = 0; i < open_segments.size(); i++) {
+                int segment = open_segments[i];
+                
+                if (ends[segment] <= blockEnd) {
+                    delete writers[segment];
+                    writers[segment] = NULL;
+                } else
+                    still_open.push_back(segment);
+            }
+            
+            open_segments = still_open;
+        }
+        
+        // Empty segments, which no block covers, still get a file.
+        try {
+            for (; next_segment < count && !failed; next_segment++) {
+                int segment = order[next_segment];
+                
+                delete new FileWrite(
+                    paths[segment],
+                    file->channels(),
+                    file->format(),
+                    file->fileRate()
+                );
+            }
+        } catch (StkError&) {
+            failed = true;
+        }
+        
+        for (int i = 0; i < count; i++)
+            delete writers[i];
+        
+        writers.clear();
+        
+        delete file;
+        file = NULL;
+        
+        if (failed)
+            throw SegmentExportException();
+    }
+}
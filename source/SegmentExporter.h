@@ -0,0 +1,104 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_SEGMENTEXPORTER_H
+#define SIRENS_SEGMENTEXPORTER_H
+
+#include "Sound.h"
+#include "FileWrite.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+/*
+    SegmentExporter - writes segments of a sound to WAV files (see
+        Sound::saveSegments), all of them in one pass over the sound.
+    
+    A segment from start frame s to end frame e covers the samples of frames
+    s to e - 1, from s * hop to (e - 1) * hop + frame (see Segmenter::
+    getSegments). The ranges are merged, and the file is read front to back
+    in blocks of getBlockSize() sample frames, skipping the gaps between
+    segments, so there is one read per block rather than a seek and read per
+    segment. While a block is encoded, the next one is read. Each segment
+    open in a block is encoded to its file by its own task, on up to
+    getThreads() threads. Segments may overlap.
+    
+    Samples are copied in the sound file's own data type and channels, so
+    segments of WAV files are bit for bit the same as the source.
+*/
+
+namespace Sirens {
+    class SegmentExporter {
+    private:
+        Sound* sound;
+        
+        // Frames of each segment, and its file.
+        vector<int> startFrames;
+        vector<int> endFrames;
+        vector<string> paths;
+        
+        int blockSize;
+        int threads;
+        
+        // Run state: sample frames of each segment, [begin, end), two blocks
+        // of samples, one read while the other is encoded, and what each
+        // task does with them.
+        vector<long> begins;
+        vector<long> ends;
+        FileRead* file;
+        StkFrames blocks[2];
+        vector<FileWrite*> writers;
+        vector<int> taskSegments;
+        vector<char> taskFailed;
+        int encodingBlock;
+        long blockBegin, blockEnd;
+        long nextBegin, nextEnd;
+        
+        void runBlockTask(int task);
+        static void runTask(int task, void* exporter);
+        
+    public:
+        SegmentExporter(Sound* sound_in);
+        ~SegmentExporter();
+        
+        // Segments, in frames. addSegments writes segment i to path_prefix
+        // followed by i and ".wav".
+        void addSegment(int start_frame, int end_frame, string path);
+        void addSegments(vector<vector<int> > segments, string path_prefix);
+        int getSegmentCount();
+        void clearSegments();
+        
+        // Attributes. The default block size is 2^18 sample frames, about
+        // six seconds at 44.1 kHz.
+        void setBlockSize(int frames) {blockSize = frames;}
+        void setThreads(int value) {threads = value;}
+        
+        int getBlockSize() {return blockSize;}
+        int getThreads() {return threads;}
+        
+        // Write every segment, reading the sound's file anew, with its frame
+        // and hop lengths. Throws SoundNotLoadedException if the sound has
+        // no file, and SegmentExportException if a file can't be read or
+        // written.
+        void run();
+    };
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SegmentationJob.h"
+
+#include "Instrumentation.h"
+
+namespace Sirens {
+    SegmentationJob::SegmentationJob(Sound* sound_in, Segmenter* segmenter_in) {
+        sound = sound_in;
+        segmenter = segmenter_in;
+        
+        checkpointPath = "";
+        checkpointInterval = 15000;
+    }
+    
+    void SegmentationJob::setCheckpoint(string path, int interval) {
+        checkpointPath = path;
+        checkpointInterval = interval;
+    }
+    
+    string SegmentationJob::getCheckpointPath() {
+        return checkpointPath;
+    }
+    
+    int SegmentationJob::getCheckpointInterval() {
+        return checkpointInterval;
+    }
+    
+    /*----------------*
+     * Checkpointing. *
+     *----------------*/
+    
+    void SegmentationJob::save() {
+        if (checkpointPath.empty())
+            return;
+        
+        SIRENS_TIMER("checkpoint:save");
+        
+        Checkpoint checkpoint;
+        
+        sound->saveState(&checkpoint);
+        sound->getFeatureSet()->saveState(&checkpoint);
+        segmenter->saveState(&checkpoint);
+        
+        checkpoint.save(checkpointPath);
+    }
+    
+    bool SegmentationJob::restore() {
+        if (checkpointPath.empty() || !Checkpoint::exists(checkpointPath))
+            return false;
+        
+        Checkpoint checkpoint;
+        checkpoint.load(checkpointPath);
+        
+        sound->loadState(&checkpoint);
+        sound->getFeatureSet()->loadState(&checkpoint);
+        segmenter->loadState(&checkpoint);
+        
+        return true;
+    }
+    
+    /*------*
+     * Run. *
+     *------*/
+    
+    void SegmentationJob::run() {
+        restore();
+        
+        int interval = checkpointPath.empty() ? 0 : checkpointInterval;
+        
+        while (sound->getExtractedFrameCount() < sound->getFrameCount()) {
+            int extracted = sound->getExtractedFrameCount();
+            
+            sound->extractAppendedFeatures(interval);
+            
+            if (sound->getExtractedFrameCount() == extracted)
+                break;
+            
+            save();
+        }
+        
+        if (segmenter->getDecimation() > 1 || segmenter->getFactorized()) {
+            segmenter->segment();
+            return;
+        }
+        
+        FeatureSet* feature_set = sound->getFeatureSet();
+        
+        while (segmenter->getDecodedFrameCount() < feature_set->getMinHistorySize()) {
+            int decoded = segmenter->getDecodedFrameCount();
+            
+            segmenter->segmentAppendedFrames(interval);
+            
+            if (segmenter->getDecodedFrameCount() == decoded)
+                break;
+            
+            save();
+        }
+    }
+}
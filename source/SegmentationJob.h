@@ -0,0 +1,93 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_SEGMENTATIONJOB_H
+#define SIRENS_SEGMENTATIONJOB_H
+
+#include "Sound.h"
+#include "Segmenter.h"
+#include "Checkpoint.h"
+
+#include <string>
+using namespace std;
+
+/*
+    SegmentationJob - extracts a sound's features and segments them, writing
+        a checkpoint to disk along the way, so that a job that dies part way
+        through a long recording picks up from the last checkpoint instead of
+        the start.
+    
+    Extraction runs getCheckpointInterval() frames at a time (see
+    Sound::extractAppendedFeatures), then segmentation the same (see
+    Segmenter::segmentAppendedFrames), with a checkpoint written after each
+    step. A checkpoint holds the extraction's place in the file, the samples
+    of the current frame, every feature's history and running state, and the
+    Viterbi frontier with the transitions decoded so far (see Checkpoint).
+    
+    run restores from the checkpoint if there is one. Restoring needs the same
+    sound file (by path), features and segmenter configuration as the job that wrote it,
+    and from there the results are bit for bit the same as a job that never
+    stopped. A finished job leaves its last checkpoint, so running it again
+    returns right away; delete the checkpoint to start over.
+    
+    Each checkpoint is written whole, with every feature's history and every
+    frame's transitions so far, so it grows with the recording: about 8 bytes
+    per feature plus 1 to 4 bytes per state for each frame, or some 100 bytes
+    per frame with three features. The total written over a job grows with
+    the square of its length; for recordings of many hours, lengthen the
+    interval to keep checkpointing a small share of the run time.
+    
+    Coarse-to-fine and factorized segmentation are not checkpointed; after
+    extraction, they run from the start.
+*/
+
+namespace Sirens {
+    class SegmentationJob {
+    private:
+        Sound* sound;
+        Segmenter* segmenter;
+        
+        string checkpointPath;
+        int checkpointInterval;
+        
+    public:
+        // The segmenter segments the sound's feature set.
+        SegmentationJob(Sound* sound_in, Segmenter* segmenter_in);
+        
+        // Where to write checkpoints, and how many frames to extract or
+        // decode between them. The default, 15000 frames, is five minutes of
+        // audio at the default hop length. Without a path, nothing is
+        // written.
+        void setCheckpoint(string path, int interval = 15000);
+        string getCheckpointPath();
+        int getCheckpointInterval();
+        
+        // Extraction and segmentation, continuing from the checkpoint if
+        // there is one. Throws CheckpointException if the checkpoint can't
+        // be read or was written by a different job.
+        void run();
+        
+        // Writing and reading checkpoints directly. restore returns false if
+        // there is no checkpoint.
+        void save();
+        bool restore();
+    };
+}
+
+#endif
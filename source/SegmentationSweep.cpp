@@ -0,0 +1,274 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SegmentationSweep.h"
+
+#include "Segmenter.h"
+#include "Thread.h"
+#include "math_support.h"
+#include "string_support.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sys/time.h>
+#include <unistd.h>
+using namespace std;
+
+namespace Sirens {
+    /*----------------*
+     * Configuration. *
+     *----------------*/
+    
+    SegmentationConfiguration::SegmentationConfiguration() {
+        pNew = 0;
+        pOff = 0;
+        beams = -1;
+        decimation = 1;
+        factorized = false;
+    }
+    
+    bool SegmentationConfiguration::load(string path) {
+        vector<vector<double> > rows;
+        
+        if (!read_csv_rows(path, rows) || rows.empty() || rows[0].size() < 3)
+            return false;
+        
+        pNew = rows[0][0];
+        pOff = rows[0][1];
+        beams = int(rows[0][2]);
+        
+        parameters.clear();
+        
+        for (int i = 1; i < rows.size(); i++) {
+            vector<double>& row = rows[i];
+            
+            if (row.size() >= 9) {
+                SegmentationParameters feature_parameters;
+                feature_parameters.alpha = row[0];
+                feature_parameters.r = row[1];
+                feature_parameters.cStayOff = row[2];
+                feature_parameters.cTurnOn = row[3];
+                feature_parameters.cTurnOff = row[4];
+                feature_parameters.cNewSegment = row[5];
+                feature_parameters.cStayOn = row[6];
+                feature_parameters.pLagPlus = row[7];
+                feature_parameters.pLagMinus = row[8];
+                
+                parameters.push_back(feature_parameters);
+            }
+        }
+        
+        return true;
+    }
+    
+    SegmentationScore::SegmentationScore() {
+        detected = 0;
+        reference = 0;
+        matched = 0;
+        precision = 0;
+        recall = 0;
+        f = 0;
+        seconds = 0;
+    }
+    
+    /*--------*
+     * Sweep. *
+     *--------*/
+    
+    SegmentationSweep::SegmentationSweep(FeatureSet* feature_set) {
+        featureSet = feature_set;
+        tolerance = 5;
+        threads = maximum(int(sysconf(_SC_NPROCESSORS_ONLN)), 1);
+    }
+    
+    SegmentationSweep::~SegmentationSweep() {
+    }
+    
+    void SegmentationSweep::setFeatureSet(FeatureSet* feature_set) {
+        featureSet = feature_set;
+    }
+    
+    FeatureSet* SegmentationSweep::getFeatureSet() {
+        return featureSet;
+    }
+    
+    void SegmentationSweep::addConfiguration(const SegmentationConfiguration& configuration) {
+        configurations.push_back(configuration);
+    }
+    
+    SegmentationConfiguration* SegmentationSweep::getConfiguration(int configuration) {
+        return &configurations[configuration];
+    }
+    
+    int SegmentationSweep::getConfigurationCount() {
+        return configurations.size();
+    }
+    
+    void SegmentationSweep::clearConfigurations() {
+        configurations.clear();
+        scores.clear();
+    }
+    
+    void SegmentationSweep::setReferenceBoundaries(vector<int> boundaries) {
+        referenceBoundaries = boundaries;
+        
+        sort(referenceBoundaries.begin(), referenceBoundaries.end());
+        referenceBoundaries.erase(
+            unique(referenceBoundaries.begin(), referenceBoundaries.end()),
+            referenceBoundaries.end()
+        );
+    }
+    
+    void SegmentationSweep::setReferenceSegments(vector<vector<int> > segments) {
+        vector<int> boundaries;
+        
+        for (int i = 0; i < segments.size(); i++)
+            boundaries.insert(boundaries.end(), segments[i].begin(), segments[i].end());
+        
+        setReferenceBoundaries(boundaries);
+    }
+    
+    vector<int> SegmentationSweep::getReferenceBoundaries() {
+        return referenceBoundaries;
+    }
+    
+    /*-------------*
+     * Segmenting. *
+     *-------------*/
+    
+    static double now() {
+        timeval time;
+        gettimeofday(&time, NULL);
+        
+        return time.tv_sec + time.tv_usec / 1000000.0;
+    }
+    
+    // Matches sorted boundaries in order; with a single tolerance, that
+    // matches as many as possible.
+    static int match_boundaries(
+        const vector<int>& detected,
+        const vector<int>& reference,
+        int tolerance
+    ) {
+        int matched = 0;
+        int i = 0;
+        int j = 0;
+        
+        while (i < detected.size() && j < reference.size()) {
+            if (abs(detected[i] - reference[j]) <= tolerance) {
+                matched++;
+                i++;
+                j++;
+            } else if (detected[i] < reference[j])
+                i++;
+            else
+                j++;
+        }
+        
+        return matched;
+    }
+    
+    void SegmentationSweep::runTask(int configuration, void* sweep) {
+        ((SegmentationSweep*)sweep)->runConfiguration(configuration);
+    }
+    
+    void SegmentationSweep::runConfiguration(int index) {
+        SegmentationConfiguration& configuration = configurations[index];
+        SegmentationScore& score = scores[index];
+        
+        Segmenter segmenter(configuration.pNew, configuration.pOff, configuration.beams);
+        segmenter.setFeatureSet(featureSet);
+        segmenter.setDecimation(configuration.decimation);
+        segmenter.setFactorized(configuration.factorized);
+        
+        int feature_count = minimum(
+            int(configuration.parameters.size()),
+            int(featureSet->getFeatures().size())
+        );
+        
+        // Rebuild the tables, in case the parameters changed since the last
+        // run.
+        for (int f = 0; f < feature_count; f++) {
+            configuration.parameters[f].createFusionLogic();
+            configuration.parameters[f].createQTable();
+            
+            segmenter.setParameters(f, &configuration.parameters[f]);
+        }
+        
+        double start = now();
+        segmenter.segment();
+        score.seconds = now() - start;
+        
+        score.segments = segmenter.getSegments();
+        
+        vector<int> boundaries;
+        
+        for (int i = 0; i < score.segments.size(); i++) {
+            boundaries.push_back(score.segments[i][0]);
+            boundaries.push_back(score.segments[i][1]);
+        }
+        
+        sort(boundaries.begin(), boundaries.end());
+        boundaries.erase(unique(boundaries.begin(), boundaries.end()), boundaries.end());
+        
+        score.detected = boundaries.size();
+        score.reference = referenceBoundaries.size();
+        score.matched = match_boundaries(boundaries, referenceBoundaries, tolerance);
+        
+        score.precision = score.detected ? double(score.matched) / score.detected : 0;
+        score.recall = score.reference ? double(score.matched) / score.reference : 0;
+        
+        if (score.precision + score.recall > 0)
+            score.f = 2 * score.precision * score.recall / (score.precision + score.recall);
+        else
+            score.f = 0;
+    }
+    
+    void SegmentationSweep::run() {
+        if (featureSet == NULL)
+            return;
+        
+        // Features' own parameters are shared by every configuration that
+        // doesn't replace them, so they are initialized before the threads
+        // start.
+        vector<Feature*> features = featureSet->getFeatures();
+        
+        for (int f = 0; f < features.size(); f++)
+            features[f]->parameters()->initialize();
+        
+        scores = vector<SegmentationScore>(configurations.size());
+        
+        run_tasks(runTask, this, configurations.size(), threads);
+    }
+    
+    SegmentationScore* SegmentationSweep::getScore(int configuration) {
+        return &scores[configuration];
+    }
+    
+    int SegmentationSweep::getBestConfiguration() {
+        int best = -1;
+        
+        for (int i = 0; i < scores.size(); i++) {
+            if (best < 0 || scores[i].f > scores[best].f)
+                best = i;
+        }
+        
+        return best;
+    }
+}
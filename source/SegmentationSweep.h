@@ -0,0 +1,134 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_SEGMENTATIONSWEEP_H
+#define SIRENS_SEGMENTATIONSWEEP_H
+
+#include "FeatureSet.h"
+#include "SegmentationParameters.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+/*
+    SegmentationSweep - segments one feature set with many configurations at
+        once and scores each against reference boundaries, for tuning
+        parameters by hand or by grid search.
+    
+    The trajectories are loaded once and shared. Each configuration gets its
+    own Segmenter, with the configuration's parameters in place of the
+    features' own (see Segmenter::setParameters), so nothing is copied or
+    parsed again per configuration. Configurations run on up to getThreads()
+    threads.
+    
+    Boundaries are the start and end frames of segments (see
+    Segmenter::getSegments). A detected boundary matches a reference boundary
+    at most getTolerance() frames away, each boundary matching at most once.
+    Precision is the fraction of detected boundaries that match, recall the
+    fraction of reference boundaries that do, and F their harmonic mean.
+*/
+
+namespace Sirens {
+    // Everything a Segmenter needs besides the feature set.
+    class SegmentationConfiguration {
+    public:
+        double pNew, pOff;
+        int beams;
+        int decimation;
+        bool factorized;
+        
+        // One for each feature. Features without one use their own.
+        vector<SegmentationParameters> parameters;
+        
+        SegmentationConfiguration();
+        
+        // Reads a parameter file as read by examples/segment_csv.cpp (see
+        // ParameterLearner::saveParameters). Returns false if it couldn't be
+        // read.
+        bool load(string path);
+    };
+    
+    class SegmentationScore {
+    public:
+        int detected, reference, matched;
+        double precision, recall, f;
+        
+        // Time taken to segment.
+        double seconds;
+        
+        vector<vector<int> > segments;
+        
+        SegmentationScore();
+    };
+    
+    class SegmentationSweep {
+    private:
+        FeatureSet* featureSet;
+        
+        vector<SegmentationConfiguration> configurations;
+        vector<SegmentationScore> scores;
+        
+        // Sorted reference boundaries.
+        vector<int> referenceBoundaries;
+        int tolerance;
+        int threads;
+        
+        void runConfiguration(int configuration);
+        static void runTask(int configuration, void* sweep);
+        
+    public:
+        SegmentationSweep(FeatureSet* feature_set = NULL);
+        ~SegmentationSweep();
+        
+        // Features.
+        void setFeatureSet(FeatureSet* feature_set);
+        FeatureSet* getFeatureSet();
+        
+        // Configurations.
+        void addConfiguration(const SegmentationConfiguration& configuration);
+        SegmentationConfiguration* getConfiguration(int configuration);
+        int getConfigurationCount();
+        void clearConfigurations();
+        
+        // Reference boundaries, in frames. setReferenceSegments uses the
+        // start and end of each segment.
+        void setReferenceBoundaries(vector<int> boundaries);
+        void setReferenceSegments(vector<vector<int> > segments);
+        vector<int> getReferenceBoundaries();
+        
+        // Attributes.
+        void setTolerance(int frames) {tolerance = frames;}
+        void setThreads(int value) {threads = value;}
+        
+        int getTolerance() {return tolerance;}
+        int getThreads() {return threads;}
+        
+        // Segment with every configuration.
+        void run();
+        
+        // Results, in the order configurations were added.
+        SegmentationScore* getScore(int configuration);
+        
+        // The configuration with the highest F, or -1 if none have run.
+        int getBestConfiguration();
+    };
+}
+
+#endif
@@ -19,8 +19,14 @@
 
 #include "Segmenter.h"
 
+#include "Instrumentation.h"
+#include "math_support.h"
+
 #include <algorithm>
 #include <cmath>
+#include <limits>
+
+#include <stdint.h>
 using namespace std;
 
 namespace Sirens {
@@ -32,6 +38,15 @@ namespace Sirens {
         progressCallback = NULL;
         featureSet = NULL;
         initialized = false;
+        states = 0;
+
+        decimation = 1;
+        decimationWindow = 50;
+
+        factorized = false;
+        factorizedIterations = 10;
+        
+        decodedFrames = 0;
     }
     
     Segmenter::~Segmenter() {
@@ -65,8 +80,8 @@ namespace Sirens {
     // feature with a Gaussian for a particular state transition.
     double Segmenter::KalmanLPF(
         double y, 
-        double p[2][2], 
-        double x[2], 
+        Matrix2& p, 
+        Vector2& x, 
         double r, 
         double q, 
         double alpha
@@ -82,27 +97,27 @@ namespace Sirens {
         x[1] = (1 - alpha) * x[0] + alpha * x[1];
         
         // Prediction covariance.
-        p[1][1] = p[0][0] * oma2 + 2 * 
-            p[0][1] * alpha * oma + 
-            p[1][1] * alpha * alpha + q * oma2;
+        p(1, 1) = p(0, 0) * oma2 + 2 * 
+            p(0, 1) * alpha * oma + 
+            p(1, 1) * alpha * alpha + q * oma2;
 
-        p[1][0] = p[0][0] * oma + p[1][0] * alpha + q * oma;
-        p[0][1] = p[1][0];
-        p[0][0] = p[0][0] + q;
+        p(1, 0) = p(0, 0) * oma + p(1, 0) * alpha + q * oma;
+        p(0, 1) = p(1, 0);
+        p(0, 0) = p(0, 0) + q;
         
         // Calculate lowpass filter error and Kalman filter residual variance.
         err = y - x[1];
-        s = p[1][1] + r;
+        s = p(1, 1) + r;
         
         // Calculate Kalman gain.
-        k[0] = p[0][1] / s;
-        k[1] = p[1][1] / s;
+        k[0] = p(0, 1) / s;
+        k[1] = p(1, 1) / s;
         
         // Update posterior estimate covariance.
-        p[0][0] -= k[0] * p[0][1];
-        p[1][0] -= k[0] * p[1][1];
-        p[0][1] = p[1][0];
-        p[1][1] -= k[1] * p[1][1];
+        p(0, 0) -= k[0] * p(0, 1);
+        p(1, 0) -= k[0] * p(1, 1);
+        p(0, 1) = p(1, 0);
+        p(1, 1) -= k[1] * p(1, 1);
         
         // Update estimate.
         x[0] += k[0] * err;
@@ -131,8 +146,7 @@ namespace Sirens {
                 double cost = 0;
                 
                 for (int fi = 0; fi < features.size(); fi++) {
-                    SegmentationParameters* parameters = 
-                        features[fi]->parameters();
+                    SegmentationParameters* parameters = featureParameters[fi];
                     
                     newDistributions[fi][ni][oi].cost = KalmanLPF(
                         y[fi],
@@ -171,15 +185,10 @@ namespace Sirens {
         // Copy best filtered distributions.
         for (int i = 0; i < states; i++) {
             for (int f = 0; f < features.size(); f++) {
-                for (int row = 0; row < 2; row++) {
-                    maxDistributions[f][i].mean[row] = 
-                        newDistributions[f][i][psi[frame][i]].mean[row];
-                    
-                    for (int column = 0; column < 2; column++) {
-                        maxDistributions[f][i].covariance[row][column] = 
-                            newDistributions[f][i][psi[frame][i]].covariance[row][column];                 
-                    }
-                }
+                maxDistributions[f][i].mean = 
+                    newDistributions[f][i][psi[frame][i]].mean;
+                maxDistributions[f][i].covariance = 
+                    newDistributions[f][i][psi[frame][i]].covariance;
             }
         }
         
@@ -187,15 +196,10 @@ namespace Sirens {
         for (int i = 0; i < states; i++) {
             for (int j = 0; j < states; j++) {
                 for (int f = 0; f < features.size(); f++) {
-                    for (int row = 0; row < 2; row ++) {
-                        newDistributions[f][i][j].mean[row] = 
-                            maxDistributions[f][i].mean[row];
-                        
-                        for (int column = 0; column < 2; column++) {
-                            newDistributions[f][i][j].covariance[row][column] = 
-                                maxDistributions[f][i].covariance[row][column];
-                        }
-                    }
+                    newDistributions[f][i][j].mean = 
+                        maxDistributions[f][i].mean;
+                    newDistributions[f][i][j].covariance = 
+                        maxDistributions[f][i].covariance;
                 }
             }
         }
@@ -208,6 +212,19 @@ namespace Sirens {
     void Segmenter::setFeatureSet(FeatureSet* feature_set) {
         featureSet = feature_set;
         features = featureSet->getFeatures();
+        
+        featureParameters = vector<SegmentationParameters*>(features.size());
+        
+        for (int i = 0; i < features.size(); i++)
+            featureParameters[i] = features[i]->parameters();
+    }
+    
+    void Segmenter::setParameters(int feature, SegmentationParameters* parameters) {
+        featureParameters[feature] = parameters;
+    }
+    
+    SegmentationParameters* Segmenter::getParameters(int feature) {
+        return featureParameters[feature];
     }
     
     FeatureSet* Segmenter::getFeatureSet() {
@@ -271,7 +288,7 @@ namespace Sirens {
                     fmold = modeMatrix[k + 1][i];
                     fmnew = modeMatrix[k + 1][j];
                     
-                    gate *= features[k]->parameters()->fusion[mold - 1][mnew - 1][fmold - 1][fmnew - 1];
+                    gate *= featureParameters[k]->fusion[mold - 1][mnew - 1][fmold - 1][fmnew - 1];
                 }
                 
                 probabilityMatrix[j][i] = log(
@@ -286,110 +303,763 @@ namespace Sirens {
         if (!initialized) {
             // Initialize prior distributions.
             for (int i = 0; i < features.size(); i++)
-                features[i]->parameters()->initialize();
-            
-            states = pow(3.0, double(features.size() + 1));
-            
-            if (beams == -1)
-                beams = states;
+                featureParameters[i]->initialize();
             
             createModeLogic();
-            createProbabilityTable();
             
-            // Initialize global mode sequence (on/off/onset for each frame).
-            modes = vector<int>(frames, 0);
+            // Initialize feature vector for current frame.
+            y = vector<double>(features.size(), 0);
             
-            // Initialize cost vectors used by Viterbi.
-            vector<double> cost_vector = vector<double>(states, 0);
-            costs = vector<vector<double> >(states, cost_vector);
-            oldCosts = vector<CostIndex>(states);
+            initialized = true;
+        }
+        
+        // The factorized decoder needs none of the joint state tables, so
+        // they're built the first time the joint decoder runs.
+        if (!factorized && states == 0)
+            createJointTables();
+    }
+    
+    // State count, beams, transition probabilities, and the costs and
+    // distributions Viterbi keeps for every state.
+    void Segmenter::createJointTables() {
+        states = pow(3.0, double(features.size() + 1));
+        
+        if (beams == -1)
+            beams = states;
+        
+        createProbabilityTable();
+        
+        // Initialize cost vectors used by Viterbi.
+        vector<double> cost_vector = vector<double>(states, 0);
+        costs = vector<vector<double> >(states, cost_vector);
+        oldCosts = vector<CostIndex>(states);
+        
+        // Initialize Gaussians used by Viterbi.
+        vector<ViterbiDistribution> temp1(states);
+        maxDistributions = vector<vector<ViterbiDistribution> >(
+            features.size(), 
+            temp1
+        );
+        
+        vector<vector<ViterbiDistribution> > temp2(states, temp1);
+        newDistributions = vector<vector<vector<ViterbiDistribution> > >(
+            features.size(), 
+            temp2
+        );
+        
+        for (int i = 0; i < features.size(); i++) {
+            for (int a = 0; a < 2; a++) {
+                maxDistributions[i][0].mean[a] = 
+                    featureParameters[i]->xInit[a];
                 
-            // Best state transitions for each state in each frame.
-            vector<int> psi_row = vector<int>(states, 0);
-            psi = vector<vector<int> >(frames, psi_row);
+                for (int b = 0; b < 2; b++) {
+                    maxDistributions[i][0].covariance(a, b) = 
+                        featureParameters[i]->pInit[a][b];
+                }
+            }
+        }
+    }
+    
+    // Size everything kept per frame for the current number of frames,
+    // keeping what is there.
+    void Segmenter::allocateFrames() {
+        // Global mode sequence (on/off/onset for each frame).
+        modes.resize(frames, 0);
+        
+        // Feature mode sequences.
+        featureModeSequences.resize(features.size());
+        
+        for (int f = 0; f < features.size(); f++)
+            featureModeSequences[f].resize(frames, 0);
+        
+        // Best state transitions for each state in each frame.
+        if (!factorized)
+            psi.resize(frames, vector<int>(states, 0));
+    }
+    
+    void Segmenter::loadHistories() {
+        histories = vector<const double*>(features.size());
+        
+        for (int j = 0; j < features.size(); j++)
+            histories[j] = features[j]->getHistory()->getData();
+    }
+    
+    
+    /*---------------*
+     * Segmentation. *
+     *---------------*/
+    
+    void Segmenter::resetDecoder(int begin, int start_mode) {
+        const double infinity = numeric_limits<double>::infinity();
+
+        // Unconstrained decoding starts from state 0 with the prior filters.
+        // Constrained decoding starts from every state in start_mode; costs
+        // the beam doesn't reach must not undercut that, so they start at
+        // infinity.
+        for (int i = 0; i < states; i++) {
+            if (start_mode == 0) {
+                oldCosts[i].cost = 0;
+                oldCosts[i].index = 0;
+            } else {
+                oldCosts[i].cost = (modeMatrix[0][i] == start_mode) ? 0 : infinity;
+                oldCosts[i].index = i;
+            }
+
+            fill(costs[i].begin(), costs[i].end(), start_mode ? infinity : 0);
+        }
+
+        for (int f = 0; f < features.size(); f++) {
+            ViterbiDistribution distribution;
+
+            if (start_mode != 0) {
+                SegmentationParameters* parameters = featureParameters[f];
+
+                distribution.mean[0] = histories[f][begin];
+                distribution.mean[1] = histories[f][begin];
+
+                for (int a = 0; a < 2; a++) {
+                    for (int b = 0; b < 2; b++)
+                        distribution.covariance(a, b) = parameters->pInit[a][b];
+                }
+            }
+
+            for (int i = 0; i < states; i++)
+                fill(newDistributions[f][i].begin(), newDistributions[f][i].end(), distribution);
+        }
+    }
+
+    void Segmenter::decode(int begin, int end, int start_mode, int end_mode) {
+        if (end <= begin)
+            return;
+
+        if (factorized) {
+            decodeFactorized(begin, end, start_mode, end_mode);
+            return;
+        }
+
+        resetDecoder(begin, start_mode);
+        decodeFrames(begin, end);
+        backtrack(begin, end, end_mode);
+    }
+
+    // For each frame, perform Viterbi, continuing from the costs and
+    // distributions the previous frame left. Timed as a whole, as frames
+    // are too short to time one by one.
+    void Segmenter::decodeFrames(int begin, int end) {
+        SIRENS_TIMER("segment:viterbi");
+        
+        for (int i = begin; i < end; i++) {
+            if (progressCallback != NULL)
+                progressCallback(i, frames);
             
-            // Initialize Gaussians used by Viterbi.
-            vector<ViterbiDistribution> temp1(states);
-            maxDistributions = vector<vector<ViterbiDistribution> >(
-                features.size(), 
-                temp1
-            );
+            for (int j = 0; j < features.size(); j++)
+                y[j] = histories[j][i];
             
-            vector<vector<ViterbiDistribution> > temp2(states, temp1);
-            newDistributions = vector<vector<vector<ViterbiDistribution> > >(
-                features.size(), 
-                temp2
-            );
+            viterbi(i);
+        }
+
+        SIRENS_COUNT("segment:decoded_frames", end - begin);
+    }
+
+    // Get the optimal state sequence for frames [begin, end) from the last
+    // frame's costs and the stored state transitions.
+    void Segmenter::backtrack(int begin, int end, int end_mode) {
+        vector<int> state_sequence(end - begin, 0);
+        
+        // Find the next state with the least cost (in end_mode, if given) and
+        // choose it to assign to the state of the last frame.
+        int last_state = -1;
+
+        for (int i = 0; i < states; i++) {
+            if (
+                (end_mode == 0 || modeMatrix[0][i] == end_mode) &&
+                (last_state < 0 || oldCosts[i].cost < oldCosts[last_state].cost)
+            )
+                last_state = i;
+        }
+
+        state_sequence[end - begin - 1] = last_state;
+        
+        // Traverse the state transitions backward from the last frame's
+        // optimal mode to get the state sequence. psi[i] holds each state's
+        // best predecessor, so frame i's state comes from frame i + 1's.
+        for (int i = end - 2; i >= begin; i--)
+            state_sequence[i - begin] = psi[i + 1][state_sequence[i - begin + 1]];
+        
+        // Find the mode sequence.
+        for (int i = begin; i < end; i++) {
+            modes[i] = modeMatrix[0][state_sequence[i - begin]];
             
-            for (int i = 0; i < features.size(); i++) {
+            for (int f = 0; f < features.size(); f++)
+                featureModeSequences[f][i] = modeMatrix[f + 1][state_sequence[i - begin]];
+        }
+    }
+
+    /*--------------------------*
+     * Factorized segmentation. *
+     *--------------------------*/
+    
+    // Decoding a feature on its own works on (global mode, feature mode)
+    // pairs, indexed (global - 1) * 3 + (feature - 1).
+    static const int PAIRS = 9;
+    
+    // Fusion transitions that are impossible cost this much when the global
+    // mode is first decoded from independently decoded features.
+    static const double IMPOSSIBLE_COST = 230;
+    
+    void Segmenter::decodeFeature(
+        int feature,
+        int begin,
+        int end,
+        int start_mode,
+        int end_mode,
+        bool fixed_global
+    ) {
+        SIRENS_TIMER("segment:feature");
+        
+        const double infinity = numeric_limits<double>::infinity();
+        SegmentationParameters* parameters = featureParameters[feature];
+        const double* history = histories[feature];
+        int n = end - begin;
+        
+        double old_costs[PAIRS];
+        double new_costs[PAIRS];
+        ViterbiDistribution old_distributions[PAIRS];
+        ViterbiDistribution new_distributions[PAIRS];
+        
+        featurePsi.assign(n * PAIRS, 0);
+        
+        // Start from the pair before the first frame: off and off, or any
+        // feature mode in start_mode with filters settled on the first value
+        // (see resetDecoder).
+        for (int s = 0; s < PAIRS; s++) {
+            if (start_mode == 0)
+                old_costs[s] = (s == 0) ? 0 : infinity;
+            else {
+                old_costs[s] = (s / 3 + 1 == start_mode) ? 0 : infinity;
+                
+                old_distributions[s].mean[0] = history[begin];
+                old_distributions[s].mean[1] = history[begin];
+                
                 for (int a = 0; a < 2; a++) {
-                    maxDistributions[i][0].mean[a] = 
-                        features[i]->parameters()->xInit[a];
+                    for (int b = 0; b < 2; b++)
+                        old_distributions[s].covariance(a, b) = parameters->pInit[a][b];
+                }
+            }
+        }
+        
+        for (int i = begin; i < end; i++) {
+            int k = i - begin;
+            
+            for (int s = 0; s < PAIRS; s++) {
+                int global = s / 3;
+                int mode = s % 3;
+                
+                // As in the joint decoder, every transition into a pair
+                // continues the filter of the best path into that pair at the
+                // previous frame. With the global mode fixed, that is the one
+                // with the same feature mode and the previous global mode.
+                int previous_global = global;
+                
+                if (fixed_global && k > 0)
+                    previous_global = globalModes[k - 1] - 1;
+                
+                new_costs[s] = infinity;
+                
+                if (fixed_global && global != globalModes[k] - 1)
+                    continue;
+                
+                for (int o = 0; o < PAIRS; o++) {
+                    int old_global = o / 3;
+                    int old_mode = o % 3;
+                    
+                    double probability = 
+                        modeTransitions[old_global][global] * 
+                        parameters->fusion[old_global][global][old_mode][mode];
+                    
+                    if (old_costs[o] == infinity || probability == 0)
+                        continue;
+                    
+                    ViterbiDistribution distribution = old_distributions[
+                        previous_global * 3 + mode
+                    ];
+                    
+                    double cost = old_costs[o] + KalmanLPF(
+                        history[i],
+                        distribution.covariance,
+                        distribution.mean,
+                        parameters->r,
+                        parameters->q[old_mode][mode],
+                        parameters->alpha
+                    ) - log(probability);
                     
-                    for (int b = 0; b < 2; b++) {
-                        maxDistributions[i][0].covariance[a][b] = 
-                            features[i]->parameters()->pInit[a][b];
+                    if (cost < new_costs[s]) {
+                        new_costs[s] = cost;
+                        new_distributions[s] = distribution;
+                        featurePsi[k * PAIRS + s] = o;
                     }
                 }
             }
             
-            // Initialize feature vector for current frame.
-            y = vector<double>(features.size(), 0);
-            
-            initialized = true;
+            for (int s = 0; s < PAIRS; s++) {
+                old_costs[s] = new_costs[s];
+                old_distributions[s] = new_distributions[s];
+            }
+        }
+        
+        int state = -1;
+        
+        for (int s = 0; s < PAIRS; s++) {
+            if (
+                (end_mode == 0 || s / 3 + 1 == end_mode) &&
+                (state < 0 || old_costs[s] < old_costs[state])
+            )
+                state = s;
         }
+        
+        for (int k = n - 1; k >= 0; k--) {
+            featureModes[feature][k + 1] = state % 3 + 1;
+            state = featurePsi[k * PAIRS + state];
+        }
+        
+        featureModes[feature][0] = state % 3 + 1;
     }
     
+    bool Segmenter::decodeGlobal(
+        int begin,
+        int end,
+        int start_mode,
+        int end_mode,
+        bool strict
+    ) {
+        const double infinity = numeric_limits<double>::infinity();
+        int n = end - begin;
+        
+        double old_costs[3];
+        double new_costs[3];
+        vector<int> global_psi(n * 3, 0);
+        
+        for (int g = 0; g < 3; g++)
+            old_costs[g] = (g + 1 == maximum(start_mode, 1)) ? 0 : infinity;
+        
+        for (int k = 0; k < n; k++) {
+            for (int g = 0; g < 3; g++) {
+                new_costs[g] = infinity;
+                
+                for (int o = 0; o < 3; o++) {
+                    if (old_costs[o] == infinity || modeTransitions[o][g] == 0)
+                        continue;
+                    
+                    double cost = old_costs[o] - log(modeTransitions[o][g]);
+                    
+                    for (int f = 0; f < features.size(); f++) {
+                        double probability = featureParameters[f]->fusion[o][g][
+                            featureModes[f][k] - 1
+                        ][
+                            featureModes[f][k + 1] - 1
+                        ];
+                        
+                        if (probability > 0)
+                            cost -= log(probability);
+                        else if (strict)
+                            cost = infinity;
+                        else
+                            cost += IMPOSSIBLE_COST;
+                    }
+                    
+                    if (cost < new_costs[g]) {
+                        new_costs[g] = cost;
+                        global_psi[k * 3 + g] = o;
+                    }
+                }
+            }
+            
+            for (int g = 0; g < 3; g++)
+                old_costs[g] = new_costs[g];
+        }
+        
+        int state = -1;
+        
+        for (int g = 0; g < 3; g++) {
+            if (
+                (end_mode == 0 || g + 1 == end_mode) &&
+                (state < 0 || old_costs[g] < old_costs[state])
+            )
+                state = g;
+        }
+        
+        bool changed = (globalModes.size() != n);
+        globalModes.resize(n);
+        
+        for (int k = n - 1; k >= 0; k--) {
+            changed = changed || (globalModes[k] != state + 1);
+            globalModes[k] = state + 1;
+            state = global_psi[k * 3 + state];
+        }
+        
+        return changed;
+    }
     
-    /*---------------*
-     * Segmentation. *
-     *---------------*/
+    void Segmenter::decodeFactorized(int begin, int end, int start_mode, int end_mode) {
+        int n = end - begin;
+        
+        featureModes = vector<vector<int> >(features.size(), vector<int>(n + 1, 1));
+        globalModes.clear();
+        
+        for (int f = 0; f < features.size(); f++) {
+            // This pass does most of the work, so progress is reported over
+            // it.
+            if (progressCallback != NULL)
+                progressCallback(begin + f * n / features.size(), frames);
+            
+            decodeFeature(f, begin, end, start_mode, end_mode, false);
+        }
+        
+        decodeGlobal(begin, end, start_mode, end_mode, false);
+        
+        for (int iteration = 0; iteration < factorizedIterations; iteration++) {
+            for (int f = 0; f < features.size(); f++)
+                decodeFeature(f, begin, end, start_mode, end_mode, true);
+            
+            if (!decodeGlobal(begin, end, start_mode, end_mode, true))
+                break;
+        }
+        
+        for (int k = 0; k < n; k++) {
+            modes[begin + k] = globalModes[k];
+            
+            for (int f = 0; f < features.size(); f++)
+                featureModeSequences[f][begin + k] = featureModes[f][k + 1];
+        }
+        
+        SIRENS_COUNT("segment:decoded_frames", n);
+    }
     
+    // Parameters for a trajectory averaged over blocks of factor frames. The
+    // lowpass filter's coefficient compounds over the block and measurement
+    // noise averages down. Process variances are left per frame rather than
+    // accumulated over the block, which makes the coarse pass quicker to
+    // flag a change than the full-rate one; that is what we want, since the
+    // full-rate pass has the final say. Lags are short next to a block, so
+    // their probabilities stay as they are.
+    static void decimate_parameters(
+        SegmentationParameters* parameters,
+        SegmentationParameters* decimated,
+        int factor
+    ) {
+        decimated->minFeatureValue = parameters->minFeatureValue;
+        decimated->maxFeatureValue = parameters->maxFeatureValue;
+        decimated->pLagPlus = parameters->pLagPlus;
+        decimated->pLagMinus = parameters->pLagMinus;
+        decimated->alpha = pow(parameters->alpha, double(factor));
+        decimated->r = parameters->r / factor;
+        decimated->cStayOff = parameters->cStayOff;
+        decimated->cStayOn = parameters->cStayOn;
+        decimated->cTurnOn = parameters->cTurnOn;
+        decimated->cTurnOff = parameters->cTurnOff;
+        decimated->cNewSegment = parameters->cNewSegment;
+
+        for (int a = 0; a < 2; a++) {
+            decimated->xInit[a] = parameters->xInit[a];
+
+            for (int b = 0; b < 2; b++)
+                decimated->pInit[a][b] = parameters->pInit[a][b];
+        }
+    }
+
+    // Probability of at least one event in factor frames.
+    static double decimate_probability(double p, int factor) {
+        return 1 - pow(1 - p, double(factor));
+    }
+
+    void Segmenter::segmentCoarseToFine() {
+        int coarse_frames = (frames + decimation - 1) / decimation;
+        int window = decimationWindow;
+
+        // Segment block averages of every feature.
+        FeatureSet coarse_set;
+        vector<Feature*> coarse_features(features.size());
+        vector<double> averages(coarse_frames);
+
+        for (int f = 0; f < features.size(); f++) {
+            for (int k = 0; k < coarse_frames; k++) {
+                int block_end = minimum((k + 1) * decimation, frames);
+                double sum = 0;
+
+                for (int i = k * decimation; i < block_end; i++)
+                    sum += histories[f][i];
+
+                averages[k] = sum / (block_end - k * decimation);
+            }
+
+            coarse_features[f] = new Feature();
+            coarse_features[f]->getHistory()->addValues(&averages[0], coarse_frames);
+
+            decimate_parameters(
+                featureParameters[f],
+                coarse_features[f]->parameters(),
+                decimation
+            );
+
+            coarse_set.addSampleFeature(coarse_features[f]);
+        }
+
+        Segmenter coarse(
+            decimate_probability(pNew, decimation),
+            decimate_probability(pOff, decimation),
+            beams
+        );
+
+        coarse.setFeatureSet(&coarse_set);
+        coarse.setFactorized(factorized, factorizedIterations);
+        coarse.segment();
+
+        vector<int> coarse_modes = coarse.getModes();
+
+        for (int f = 0; f < features.size(); f++)
+            delete coarse_features[f];
+
+        // Frames are off except in windows around the blocks the coarse pass
+        // found not off, which are decoded again at full resolution, starting
+        // and ending off. Windows that overlap or touch are merged.
+        for (int i = 0; i < frames; i++) {
+            modes[i] = 1;
+            
+            for (int f = 0; f < features.size(); f++)
+                featureModeSequences[f][i] = 1;
+        }
+
+        vector<int> window_begins;
+        vector<int> window_ends;
+
+        for (int k = 0; k < coarse_frames; k++) {
+            if (coarse_modes[k] != 1) {
+                int begin = maximum(k * decimation - window, 0);
+                int end = minimum((k + 1) * decimation + window, frames);
+
+                if (!window_ends.empty() && begin <= window_ends.back())
+                    window_ends.back() = end;
+                else {
+                    window_begins.push_back(begin);
+                    window_ends.push_back(end);
+                }
+            }
+        }
+
+        for (int w = 0; w < window_begins.size(); w++) {
+            int begin = window_begins[w];
+            int end = window_ends[w];
+
+            decode(begin, end, begin > 0 ? 1 : 0, end < frames ? 1 : 0);
+        }
+    }
+
     void Segmenter::segment() {
+        SIRENS_TIMER("segment");
+        
         if (featureSet != NULL) {
             frames = featureSet->getMinHistorySize();
             
+            SIRENS_COUNT("segment:frames", frames);
+            
             initialize();
+            allocateFrames();
+            loadHistories();
             
-            // For each frame, perform Viterbi and get the optimal state
-            // sequence.
-            for (int i = 0; i < frames; i++) {
-                if (progressCallback != NULL)
-                    progressCallback(i, frames);
+            decodedFrames = 0;
+            
+            if (decimation > 1 && frames > decimation)
+                segmentCoarseToFine();
+            else {
+                decode(0, frames, 0, 0);
                 
-                for (int j = 0; j < features.size(); j++)
-                    y[j] = features[j]->getHistoryFrame(i);
+                if (!factorized)
+                    decodedFrames = frames;
+            }
+        }
+    }
+    
+    void Segmenter::segmentAppendedFrames(int max_frames) {
+        if (featureSet == NULL)
+            return;
+        
+        int new_frames = featureSet->getMinHistorySize();
+        
+        // Only the joint decoder leaves a frontier to continue from.
+        if (decimation > 1 || factorized || new_frames < decodedFrames) {
+            segment();
+            return;
+        }
+        
+        if (max_frames > 0)
+            new_frames = minimum(new_frames, decodedFrames + max_frames);
+        
+        SIRENS_TIMER("segment");
+        
+        frames = new_frames;
+        
+        SIRENS_COUNT("segment:frames", frames - decodedFrames);
+        
+        initialize();
+        allocateFrames();
+        loadHistories();
+        
+        // Nothing decoded yet: start from the prior, as segment does.
+        if (decodedFrames == 0)
+            resetDecoder(0, 0);
+        
+        decodeFrames(decodedFrames, frames);
+        
+        if (frames > 0)
+            backtrack(0, frames, 0);
+        
+        decodedFrames = frames;
+    }
+    
+    int Segmenter::getDecodedFrameCount() {
+        return decodedFrames;
+    }
+    
+    /*----------------*
+     * Checkpointing. *
+     *----------------*/
+    
+    // Stored transitions take the fewest bytes that hold every state, as
+    // they make up most of a checkpoint.
+    static int transition_size(int states) {
+        if (states <= 256)
+            return 1;
+        else if (states <= 65536)
+            return 2;
+        else
+            return 4;
+    }
+    
+    // The frontier is what viterbi carries from one frame to the next: the
+    // costs of the last frame (including transitions the beams left stale),
+    // and the best filtered distributions, which every transition out of a
+    // state starts from. With the stored transitions, that is all
+    // segmentAppendedFrames needs to continue.
+    void Segmenter::saveState(Checkpoint* checkpoint) {
+        checkpoint->writeInt(features.size());
+        checkpoint->writeInt(decodedFrames);
+        
+        if (decodedFrames == 0)
+            return;
+        
+        checkpoint->writeInt(states);
+        checkpoint->writeInt(beams);
+        
+        for (int i = 0; i < states; i++) {
+            checkpoint->writeDouble(oldCosts[i].cost);
+            checkpoint->writeInt(oldCosts[i].index);
+        }
+        
+        for (int i = 0; i < states; i++)
+            checkpoint->writeDoubles(&costs[i][0], states);
+        
+        for (int f = 0; f < features.size(); f++) {
+            for (int i = 0; i < states; i++) {
+                ViterbiDistribution& distribution = maxDistributions[f][i];
                 
-                viterbi(i);
+                for (int a = 0; a < 2; a++) {
+                    checkpoint->writeDouble(distribution.mean[a]);
+                    
+                    for (int b = 0; b < 2; b++)
+                        checkpoint->writeDouble(distribution.covariance(a, b));
+                }
+            }
+        }
+        
+        int size = transition_size(states);
+        vector<char> row(states * size);
+        
+        for (int i = 0; i < decodedFrames; i++) {
+            for (int j = 0; j < states; j++) {
+                if (size == 1)
+                    ((uint8_t*)&row[0])[j] = psi[i][j];
+                else if (size == 2)
+                    ((uint16_t*)&row[0])[j] = psi[i][j];
+                else
+                    ((int32_t*)&row[0])[j] = psi[i][j];
             }
             
-            vector<int> state_sequence(frames, 0);
-            
-            // Find the next state with the least cost and choose it to assign
-            // to the state of the last frame.
-            vector<CostIndex>::iterator minimum_cost = min_element(
-                oldCosts.begin(), 
-                oldCosts.end()
-            );
-
-            state_sequence[frames - 1] = distance(
-                oldCosts.begin(), 
-                minimum_cost
-            );
-            
-            // Find the "off" states and "on"/"onset" states that have minimum
-            // cost. 
-            int start = (states / 3);
+            checkpoint->write(&row[0], row.size());
+        }
+    }
+    
+    void Segmenter::loadState(Checkpoint* checkpoint) {
+        checkpoint->expectInt(features.size());
+        
+        int decoded_frames = checkpoint->readInt();
+        
+        decodedFrames = 0;
+        
+        if (decoded_frames == 0)
+            return;
+        
+        if (decoded_frames < 0 || factorized)
+            throw CheckpointException();
+        
+        initialize();
+        
+        checkpoint->expectInt(states);
+        checkpoint->expectInt(beams);
+        
+        for (int i = 0; i < states; i++) {
+            oldCosts[i].cost = checkpoint->readDouble();
+            oldCosts[i].index = checkpoint->readInt();
             
-            // Traverse the state transitions backward from the last frame's
-            // optimal mode to get the state sequence.
-            for (int i = frames - 2; i > -1; i--)
-                state_sequence[i] = psi[i][state_sequence[i + 1]];
+            if (oldCosts[i].index < 0 || oldCosts[i].index >= states)
+                throw CheckpointException();
+        }
+        
+        for (int i = 0; i < states; i++)
+            checkpoint->readDoubles(&costs[i][0], states);
+        
+        for (int f = 0; f < features.size(); f++) {
+            for (int i = 0; i < states; i++) {
+                ViterbiDistribution& distribution = maxDistributions[f][i];
+                
+                for (int a = 0; a < 2; a++) {
+                    distribution.mean[a] = checkpoint->readDouble();
+                    
+                    for (int b = 0; b < 2; b++)
+                        distribution.covariance(a, b) = checkpoint->readDouble();
+                }
+                
+                for (int j = 0; j < states; j++) {
+                    newDistributions[f][i][j].mean = distribution.mean;
+                    newDistributions[f][i][j].covariance = distribution.covariance;
+                }
+            }
+        }
+        
+        frames = decoded_frames;
+        allocateFrames();
+        
+        int size = transition_size(states);
+        vector<char> row(states * size);
+        
+        for (int i = 0; i < frames; i++) {
+            checkpoint->read(&row[0], row.size());
             
-            // Find the mode sequence.
-            for (int i = 0; i < frames; i++)
-                modes[i] = modeMatrix[0][state_sequence[i]];
+            for (int j = 0; j < states; j++) {
+                if (size == 1)
+                    psi[i][j] = ((uint8_t*)&row[0])[j];
+                else if (size == 2)
+                    psi[i][j] = ((uint16_t*)&row[0])[j];
+                else
+                    psi[i][j] = ((int32_t*)&row[0])[j];
+                
+                if (psi[i][j] < 0 || psi[i][j] >= states)
+                    throw CheckpointException();
+            }
         }
+        
+        backtrack(0, frames, 0);
+        
+        decodedFrames = frames;
     }
     
     
@@ -426,4 +1096,8 @@ namespace Sirens {
     vector<int> Segmenter::getModes() {
         return modes;
     }
+    
+    vector<int> Segmenter::getFeatureModeSequence(int feature) {
+        return featureModeSequences[feature];
+    }
 }
@@ -22,6 +22,8 @@
 
 #include "Feature.h"
 #include "FeatureSet.h"
+#include "FixedMatrix.h"
+#include "Checkpoint.h"
 
 #include <vector>
 using namespace std;
@@ -87,24 +89,49 @@ using namespace std;
 
     For information on how to determine the parameters used in this algorithm,
     please see SegmentationParameters.h
+
+    Coarse-to-fine segmentation:
+    For long recordings with few events, most frames are spent confirming
+    that nothing changes. With setDecimation(factor), the trajectories are
+    first averaged over blocks of factor frames and segmented at that rate,
+    with the parameters adjusted to match (see decimate_parameters in
+    Segmenter.cpp). Only windows around the blocks that pass finds not off
+    are then decoded at full resolution, each starting and ending off; every
+    other frame is off. Events the coarse pass misses entirely, such as ones
+    shorter than a block or two, are lost, so this suits recordings that are
+    mostly quiet, with events that last a while.
+
+    Factorized segmentation:
+    The joint state space grows as 3^(N + 1), which rules out more than three
+    or four features. Each feature's mode only depends on the global mode
+    (see SegmentationParameters::fusion), and given the global mode sequence
+    the features are independent, so setFactorized(true) decodes them apart:
+        1. Each feature is decoded on its own, with its own global mode (9
+            states, as if it were the only feature).
+        2. The global mode sequence is decoded given every feature's mode
+            sequence (3 states). The feature modes from step 1 needn't agree
+            on a global mode, so here transitions the fusion logic forbids are
+            only heavily penalized.
+        3. Each feature is decoded again with the global mode fixed (3
+            states), then the global mode given those, until it stops
+            changing or after setFactorized's iterations.
+    Step 2 and the global half of step 3 are exact, so the alternation only
+    ever lowers the total cost, in the spirit of the structured variational
+    approximation in Ghahramani and Hinton (above), with hard assignments in
+    place of posteriors. The cost is linear in N rather than exponential, at
+    the price of finding a local rather than global optimum.
 */
 
 namespace Sirens {
     class ViterbiDistribution {
     public:
-        double mean[2];
-        double covariance[2][2];
+        Vector2 mean;
+        Matrix2 covariance;
         double cost;
 
         ViterbiDistribution() {
-            mean[0] = 0;
-            mean[1] = 0;
+            covariance = Matrix2::identity();
             cost = 0;
-
-            covariance[0][0] = 1;
-            covariance[0][1] = 0;
-            covariance[1][0] = 0;
-            covariance[1][1] = 1;
         }
     };
 
@@ -127,6 +154,7 @@ namespace Sirens {
     private:
         FeatureSet* featureSet;
         vector<Feature*> features;
+        vector<SegmentationParameters*> featureParameters;
 
         // Initialization.
         bool initialized;
@@ -152,7 +180,8 @@ namespace Sirens {
         // Costs of every possible state transition.
         vector<vector<double> > costs;
 
-        // Stored state sequences.
+        // Stored state sequences: psi[i][j] is the best state at frame i - 1
+        // for state j at frame i.
         vector<vector<int> > psi;
 
         // Minimum cost list for previous frame.
@@ -172,18 +201,67 @@ namespace Sirens {
         vector<int> getFeatureModes(int state);
 
         // Algorithms.
-        double KalmanLPF(
-            double y,
-            double p[2][2],
-            double x[2],
-            double r,
-            double q,
-            double alpha
+        void viterbi(int frame);
+
+        // Viterbi decoding of frames [begin, end) into modes. start_mode, if
+        // not 0, is the global mode of frame begin - 1, and the decoding
+        // starts from filters settled on the first frame's values rather than
+        // from the prior. end_mode, if not 0, is the global mode frame
+        // end - 1 must end in.
+        void resetDecoder(int begin, int start_mode);
+        void decode(int begin, int end, int start_mode, int end_mode);
+        void decodeFrames(int begin, int end);
+        void backtrack(int begin, int end, int end_mode);
+
+        // Frames decoded by the last full decoding, whose costs and
+        // distributions are where Viterbi left them (see
+        // segmentAppendedFrames). 0 if there are none to continue from.
+        int decodedFrames;
+
+        void allocateFrames();
+        void loadHistories();
+
+        // Feature values for every frame (see segment).
+        vector<const double*> histories;
+
+        // Coarse-to-fine segmentation.
+        int decimation;
+        int decimationWindow;
+
+        void segmentCoarseToFine();
+
+        // Factorized segmentation.
+        bool factorized;
+        int factorizedIterations;
+
+        // Modes of every feature, and the global mode, for each frame being
+        // decoded. Feature modes are preceded by the mode before the first
+        // frame.
+        vector<vector<int> > featureModes;
+        vector<int> globalModes;
+
+        // Stored (global mode, feature mode) pairs for decodeFeature.
+        vector<int> featurePsi;
+
+        // Decode a feature's modes into featureModes, along with a global
+        // mode of its own, or with globalModes if fixed_global is true.
+        void decodeFeature(
+            int feature,
+            int begin,
+            int end,
+            int start_mode,
+            int end_mode,
+            bool fixed_global
         );
 
-        void viterbi(int frame);
+        // Decode globalModes given featureModes. Returns whether they
+        // changed.
+        bool decodeGlobal(int begin, int end, int start_mode, int end_mode, bool strict);
+
+        void decodeFactorized(int begin, int end, int start_mode, int end_mode);
 
         vector<int> modes;
+        vector<vector<int> > featureModeSequences;
         int states;
         int beams;
         void(* progressCallback)(int, int);
@@ -195,6 +273,12 @@ namespace Sirens {
         // Features.
         void setFeatureSet(FeatureSet* feature_set);
         FeatureSet* getFeatureSet();
+        
+        // Parameters for a feature, in place of the feature's own, so that
+        // segmenters can share a feature set but not parameters (see
+        // SegmentationSweep). Call after setFeatureSet.
+        void setParameters(int feature, SegmentationParameters* parameters);
+        SegmentationParameters* getParameters(int feature);
 
         // Attributes.
         void setProgressCallback(void(*callback)(int, int)) {
@@ -209,17 +293,83 @@ namespace Sirens {
         double getPOff() {return pOff;}
         int getBeams() {return beams;}
 
+        // Coarse-to-fine segmentation (see above). factor is the number of
+        // frames averaged per coarse frame, and window the number of frames
+        // decoded at full resolution either side of each coarse event; the
+        // filters need about a second of context to agree with a full
+        // decoding. A factor of 1, the default, decodes every frame.
+        void setDecimation(int factor, int window = 50) {
+            decimation = factor;
+            decimationWindow = window;
+        }
+
+        int getDecimation() {return decimation;}
+
+        // Factorized segmentation (see above), for more features than the
+        // joint state space allows. iterations bounds the alternation between
+        // feature and global modes. Beams are not used.
+        void setFactorized(bool value, int iterations = 10) {
+            factorized = value;
+            factorizedIterations = iterations;
+        }
+
+        bool getFactorized() {return factorized;}
+
         // Initialization.
         void createModeLogic();
         void createProbabilityTable();
+        void createJointTables();
         void initialize();
 
         // Segmentation. This is what users call.
         void segment();
 
+        // Segments again after frames were appended to the features'
+        // histories (see Sound::extractAppendedFeatures), decoding only the
+        // new frames: Viterbi continues from the last frame's costs and
+        // distributions, and only the backtracking covers every frame. The
+        // result is the same as segment's. Histories must keep every frame
+        // (the default, see Feature). Coarse-to-fine and factorized
+        // segmentation decode everything again. max_frames, if not 0, stops
+        // after that many new frames, and the modes cover only the frames
+        // decoded so far, so that long decodings can be checkpointed along
+        // the way (see SegmentationJob). Starts from the first frame if
+        // nothing has been decoded yet.
+        void segmentAppendedFrames(int max_frames = 0);
+
+        // Frames segmentAppendedFrames can continue from.
+        int getDecodedFrameCount();
+
+        // Checkpointing (see Checkpoint). The Viterbi frontier and the stored
+        // state transitions of the decoded frames, from which the modes are
+        // recovered on loading. loadState needs a segmenter with the same
+        // features, parameters and beams, and throws CheckpointException if
+        // the number of states or beams differs. Nothing is saved after
+        // coarse-to-fine or factorized segmentation, and loading into a
+        // factorized segmenter throws.
+        void saveState(Checkpoint* checkpoint);
+        void loadState(Checkpoint* checkpoint);
+
         // Retrieve results after segmentation.
         vector<vector<int> > getSegments();
         vector<int> getModes();
+
+        // Mode of one feature for every frame, as decoded alongside the
+        // global modes.
+        vector<int> getFeatureModeSequence(int feature);
+
+        // Filter the feature trajectory one frame for a particular feature
+        // mode transition, with process variance q, returning the cost (a
+        // negative log-likelihood) of the observation y. Also used to fit
+        // parameters (see ParameterLearner).
+        static double KalmanLPF(
+            double y,
+            Matrix2& p,
+            Vector2& x,
+            double r,
+            double q,
+            double alpha
+        );
     };
 }
 
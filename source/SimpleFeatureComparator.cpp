@@ -57,11 +57,12 @@ namespace Sirens {
      *---------------------*/
     void SimpleFeatureComparator::fitGaussian(){
         int history_size = feature->getHistorySize();
+        const double* history = feature->getHistory()->getData();
         
         //calculate the mean
         featureMean = 0;
         for (int i = 0; i < history_size; i++)
-            featureMean += feature->getHistoryFrame(i);
+            featureMean += history[i];
         featureMean /= double(history_size);
         
         //calculate the variance (unbiased formulation)
@@ -69,7 +70,7 @@ namespace Sirens {
         double meanCenter;
         
         for (int i =0; i < history_size; i++){
-            meanCenter = feature->getHistoryFrame(i) - featureMean;
+            meanCenter = history[i] - featureMean;
             featureVariance += (meanCenter*meanCenter);
         }
         
@@ -106,10 +107,11 @@ namespace Sirens {
             
         Feature* other_trajectory = model->getFeature();
         int frames = other_trajectory->getHistorySize();
+        const double* history = other_trajectory->getHistory()->getData();
         double meanCenter, log_lik = 0;
         
         for (int i = 0; i < frames; i++){
-            meanCenter = other_trajectory->getHistoryFrame(i) - featureMean;
+            meanCenter = history[i] - featureMean;
             log_lik -= (0.5 * meanCenter * meanCenter / featureVariance);
         }
         
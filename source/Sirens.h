@@ -21,14 +21,25 @@
 #define SIRENS_H
 
 #include "Feature.h"
+#include "Instrumentation.h"
+#include "Arena.h"
 #include "FeatureSet.h"
+#include "TrajectoryFile.h"
+#include "Checkpoint.h"
+#include "SpectralStatistics.h"
+#include "SampleStatistics.h"
 #include "Sound.h"
+#include "SegmentExporter.h"
+#include "StreamingExtractor.h"
 #include "SoundComparator.h"
 #include "FeatureComparator.h"
 #include "SimpleSoundComparator.h"
 #include "SimpleFeatureComparator.h"
 #include "SegmentationParameters.h"
 #include "Segmenter.h"
+#include "ParameterLearner.h"
+#include "SegmentationSweep.h"
+#include "SegmentationJob.h"
 #include "Harmonicity.h"
 #include "Loudness.h"
 #include "SpectralCentroid.h"
@@ -0,0 +1,69 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_SLIDINGMAXIMUM_H
+#define SIRENS_SLIDINGMAXIMUM_H
+
+// Peak picking over a spectrum: a bin is a peak if it is the maximum of the
+// window of halfWidth bins either side of it. Bins are added in order, and
+// the window maximum is tracked with a monotonic deque of bin indices whose
+// values decrease from front to back, so every bin is pushed and popped at
+// most once. The deque lives in a caller-owned buffer of at least as many
+// ints as bins added, so callers can keep it in their own allocations and
+// fold peak picking into other per-bin loops.
+namespace Sirens {
+    class SlidingMaximum {
+    private:
+        int* indices;
+        int front, back;
+        int firstBin, halfWidth;
+        
+    public:
+        SlidingMaximum(int* indices_in, int first_bin, int half_width) {
+            indices = indices_in;
+            front = back = 0;
+            firstBin = first_bin;
+            halfWidth = half_width;
+        }
+        
+        // Adds bin i of data, starting from first_bin. Once the window centered
+        // on bin i - halfWidth is full, returns whether that bin is its
+        // maximum.
+        bool add(const double* data, int i) {
+            while (back > front && data[indices[back - 1]] <= data[i])
+                back --;
+            
+            indices[back] = i;
+            back ++;
+            
+            int k = i - halfWidth;
+            
+            if (k < firstBin + halfWidth)
+                return false;
+            
+            // Drop bins that slid out of the left side of the window.
+            if (indices[front] < k - halfWidth)
+                front ++;
+            
+            return data[k] >= data[indices[front]];
+        }
+    };
+}
+
+#endif
@@ -18,11 +18,13 @@
 */
 
 #include "Sound.h"
+#include "SegmentExporter.h"
 
 #include "FFT.h"
 #include "CircularArray.h"
 #include "math_support.h"
 #include "string_support.h"
+#include "Instrumentation.h"
 
 namespace Sirens {
     Sound::Sound() {
@@ -31,6 +33,10 @@ namespace Sirens {
         channelOption = 0;
 
         path = "";
+        soundFile = NULL;
+        featureSet = NULL;
+        sampleArray = NULL;
+        nextHop = 0;
     }
 
     Sound::Sound(string path_in) {
@@ -38,11 +44,18 @@ namespace Sirens {
         hopLength = 0.02;
         channelOption = 0;
 
+        soundFile = NULL;
+        featureSet = NULL;
+        sampleArray = NULL;
+        nextHop = 0;
+
         open(path_in);
     }
 
     Sound::~Sound() {
         close();
+
+        delete sampleArray;
     }
 
     /*-----*
@@ -50,53 +63,23 @@ namespace Sirens {
      *-----*/
 
     void Sound::open(string path_in) {
+        // Reopening a file that has grown keeps the extraction state.
+        close();
+
         path = path_in;
         soundFile = new FileRead(path.c_str());
     }
 
     void Sound::saveSegment(string path_out, int start_frame, int end_frame) {
-    /*
-        if (soundFile.isOpen()) {
-            // Sample buffer is the size of one hop * #channels.
-            int samples_per_hop = getSamplesPerHop() * getChannels();
-            int samples_per_frame = getSamplesPerFrame() * getChannels();
-            double* hop_samples = new double[samples_per_hop];
-
-            // Open the segment file.
-            SNDFILE* segment = sf_open(path_out.c_str(), SFM_WRITE, &soundInfo);
-
-            if (segment) {
-                // Get the last frame in its entirety.
-                int first_sample = samples_per_hop * start_frame;
-                int last_sample = samples_per_hop * (end_frame - 1) + samples_per_frame;
-
-                int samples_read = 0;
-                int readcount = 0;
-
-                // Reset the file pointer.
-                sf_seek(soundFile, 0, SEEK_SET);
-
-                // Begin reading data from the sound, one hop at a time.
-                while (readcount = sf_read_double(soundFile, hop_samples, samples_per_hop)) {
-                    if (samples_read >= first_sample && samples_read < last_sample) {
-                        int samples_to_write = samples_per_hop;
-                        int samples_left = last_sample - samples_read;
-
-                        if (samples_left < samples_per_hop)
-                            samples_to_write = samples_left;
-
-                        sf_write_double(segment, hop_samples, samples_per_hop);
-                    } else if (samples_read >= last_sample)
-                        break;
-
-                    samples_read += readcount;
-                }
+        SegmentExporter exporter(this);
+        exporter.addSegment(start_frame, end_frame, path_out);
+        exporter.run();
+    }
 
-                sf_close(segment);
-            }
-        } else
-            throw SoundNotLoadedException();
-    */
+    void Sound::saveSegments(vector<vector<int> > segments, string path_prefix) {
+        SegmentExporter exporter(this);
+        exporter.addSegments(segments, path_prefix);
+        exporter.run();
     }
 
     void Sound::close() {
@@ -197,10 +180,66 @@ namespace Sirens {
         featureSet = feature_set;
     }
 
-    void Sound::extractFeatures()  {
+    void Sound::extractFeatures() {
+        delete sampleArray;
+        sampleArray = new CircularArray(getSamplesPerFrame());
+        nextHop = 0;
+
+        extractHops(0);
+    }
+
+    void Sound::extractAppendedFeatures(int max_frames) {
+        if (sampleArray == NULL || sampleArray->getMaxSize() != getSamplesPerFrame()) {
+            delete sampleArray;
+            sampleArray = new CircularArray(getSamplesPerFrame());
+            nextHop = 0;
+        }
+
+        extractHops(max_frames);
+    }
+
+    int Sound::getExtractedFrameCount() {
+        return nextHop;
+    }
+
+    void Sound::saveState(Checkpoint* checkpoint) {
+        checkpoint->writeString(path);
+        checkpoint->writeInt(getSampleRate());
+        checkpoint->writeInt(getChannels());
+        checkpoint->writeInt(getSamplesPerFrame());
+        checkpoint->writeInt(getSamplesPerHop());
+        checkpoint->writeInt(nextHop);
+        checkpoint->writeInt(sampleArray != NULL);
+
+        if (sampleArray != NULL)
+            sampleArray->saveState(checkpoint);
+    }
+
+    void Sound::loadState(Checkpoint* checkpoint) {
+        checkpoint->expectString(path);
+        checkpoint->expectInt(getSampleRate());
+        checkpoint->expectInt(getChannels());
+        checkpoint->expectInt(getSamplesPerFrame());
+        checkpoint->expectInt(getSamplesPerHop());
+
+        nextHop = checkpoint->readInt();
+
+        delete sampleArray;
+        sampleArray = NULL;
+
+        if (checkpoint->readInt()) {
+            sampleArray = new CircularArray(getSamplesPerFrame());
+            sampleArray->loadState(checkpoint);
+        }
+    }
+
+    // Reads hops from nextHop to the end of the file, or max_frames of them.
+    void Sound::extractHops(int max_frames) {
+        SIRENS_TIMER(Instrumentation::intern("extract:file:" + path));
+        
         if (soundFile->isOpen()) {
             // Samples of the current frame.
-            CircularArray sample_array(getSamplesPerFrame());
+            CircularArray& sample_array = *sampleArray;
 
             // Windowed samples of the current frame, pad with 0s for STFT.
             CircularArray windowed_array(getSamplesPerFrame(), getFFTSize());
@@ -214,9 +253,12 @@ namespace Sirens {
             FFT fft(getFFTSize(), windowed_array.getData());
 
             // Start reading in frames.
-            long frame_number = 0;
+            int frame_count = getFrameCount();
+
+            if (max_frames > 0)
+                frame_count = minimum(frame_count, nextHop + max_frames);
 
-            for (int f = 0; f < getFrameCount(); f++) {
+            for (int f = nextHop; f < frame_count; f++) {
                 StkFrames samples(getSamplesPerHop(), soundFile->channels());
                 soundFile->read(samples, getSamplesPerHop() * f);
                 StkFloat* sample_value = &samples[0];
@@ -274,10 +316,13 @@ namespace Sirens {
 
                     // Calculate spectral features.
                     featureSet->calculateSpectralFeatures(&spectrum_array);
-                    frame_number = frame_number + 1;
+                    
+                    SIRENS_COUNT("extract:frames", 1);
                 }
             }
 
+            nextHop = maximum(nextHop, frame_count);
+
             // Cleanup.
             delete [] window;
         }
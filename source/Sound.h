@@ -30,6 +30,7 @@ using namespace std;
 using namespace stk;
 
 #include "FeatureSet.h"
+#include "CircularArray.h"
 
 namespace Sirens {
     class Sound {
@@ -45,6 +46,13 @@ namespace Sirens {
 
         FeatureSet* featureSet;
 
+        // Samples of the current frame and the next hop to read, kept
+        // between extractions (see extractAppendedFeatures).
+        CircularArray* sampleArray;
+        int nextHop;
+
+        void extractHops(int max_frames);
+
     public:
         Sound();
         Sound(string path_in);
@@ -53,6 +61,11 @@ namespace Sirens {
         // I/O.
         void open(string path_in);
         void saveSegment(string path_out, int start_frame, int end_frame);
+
+        // Writes every segment (see Segmenter::getSegments) to path_prefix
+        // followed by its index and ".wav", in one pass over the file (see
+        // SegmentExporter). Prefer this to saveSegment for many segments.
+        void saveSegments(vector<vector<int> > segments, string path_prefix);
         void close();
 
         // Basic sound information.
@@ -78,6 +91,28 @@ namespace Sirens {
         FeatureSet* getFeatureSet();
         void setFeatureSet(FeatureSet* feature_set);
         void extractFeatures();
+
+        // Extracts features for only the frames added to the file since the
+        // last extraction, for recordings that grow, such as field captures
+        // appended to daily. Reopen the file with open first, so that its
+        // new length is seen. Features carry their own state from frame to
+        // frame, and this continues from the samples of the last frame, so
+        // with the same features, frame and hop lengths, the result is the
+        // same as extracting the whole file at once. Extracts everything if
+        // nothing has been extracted yet. max_frames, if not 0, stops after
+        // that many frames, so that long extractions can be checkpointed
+        // along the way (see SegmentationJob).
+        void extractAppendedFeatures(int max_frames = 0);
+
+        // Frames read from the file so far.
+        int getExtractedFrameCount();
+
+        // Checkpointing (see Checkpoint). The extraction's place in the file
+        // and the samples of the current frame; the feature set saves its own
+        // state. loadState throws CheckpointException if the path, sample
+        // rate, channel count, frame size or hop size differs.
+        void saveState(Checkpoint* checkpoint);
+        void loadState(Checkpoint* checkpoint);
     };
 }
 
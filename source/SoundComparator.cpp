@@ -19,6 +19,8 @@
 
 #include "SoundComparator.h"
 
+#include "Instrumentation.h"
+
 namespace Sirens {
     SoundComparator::SoundComparator(FeatureSet* feature_set) {
         setFeatureSet(feature_set);
@@ -58,6 +60,9 @@ namespace Sirens {
     }
 
     double SoundComparator::compare(SoundComparator* sound_comparator) {
+        SIRENS_TIMER("compare:sound");
+        SIRENS_COUNT("compare:pairs", 1);
+        
         vector<FeatureComparator*> other_comparators = 
             sound_comparator->getFeatureComparators();
         
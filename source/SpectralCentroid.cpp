@@ -20,6 +20,8 @@
 #include "SpectralCentroid.h"
 
 #include "math_support.h"
+#include "TableCache.h"
+#include "SpectralStatistics.h"
 
 namespace Sirens {
     SpectralCentroid::SpectralCentroid(
@@ -36,30 +38,34 @@ namespace Sirens {
         setSampleRate(sample_rate);
     }
 
+    SpectralCentroid::SpectralCentroid(
+        const SpectralCentroid& other
+    ) : Feature(other) {
+        spectrumSize = other.spectrumSize;
+        sampleRate = other.sampleRate;
+        
+        barkWeights = NULL;
+        barkUnits = NULL;
+        
+        if (initialized)
+            initialize();
+    }
+
     SpectralCentroid::~SpectralCentroid() {
         freeMemory();
     }
     
     void SpectralCentroid::freeMemory() {
-        if (barkUnits)
-            delete [] barkUnits;
+        TableCache::release(barkUnits);
+        TableCache::release(barkWeights);
         
-        if (barkWeights)
-            delete [] barkWeights;
+        barkUnits = NULL;
+        barkWeights = NULL;
     }
     
     void SpectralCentroid::initialize() {
-        barkUnits = new double[spectrumSize];
-        barkWeights = new double[spectrumSize - 1];
-        
-        for (int i = 0; i < spectrumSize; i++) {
-            barkUnits[i] = hz_to_bark(
-                double(sampleRate * i) / double(2 * (spectrumSize - 1))
-            );
-        }
-        
-        for (int i = 0; i < spectrumSize - 1; i++)
-            barkWeights[i] = barkUnits[i + 1] - barkUnits[i];
+        barkUnits = TableCache::acquireBarkUnits(spectrumSize, sampleRate);
+        barkWeights = TableCache::acquireBarkWeights(spectrumSize, sampleRate);
         
         initialized = true;
     }
@@ -89,7 +95,7 @@ namespace Sirens {
         value = 0;
         
         int size = input->getSize();
-        double* weight_item = barkWeights;
+        const double* weight_item = barkWeights;
         double* input_item = input->getData() + 1;
         
         for (int i = 1; i < size; i++) {
@@ -100,7 +106,7 @@ namespace Sirens {
         }
         
         weight_item = barkWeights;
-        double* unit_item = barkUnits + 1;
+        const double* unit_item = barkUnits + 1;
         input_item = input->getData() + 1;
         if (sum) {
             for (int i = 1; i < size; i++) {
@@ -114,6 +120,28 @@ namespace Sirens {
 
     }
 
+    bool SpectralCentroid::configureStatistics(SpectralStatistics* statistics) {
+        statistics->requestBarkMoments(spectrumSize, sampleRate);
+        
+        return true;
+    }
+    
+    bool SpectralCentroid::performFusedCalculation(SpectralStatistics* statistics) {
+        if (!statistics->hasBarkMoments(spectrumSize, sampleRate))
+            return false;
+        
+        // The centroid is the bark-weighted first moment divided by the total
+        // weighted energy. This divides once rather than once per bin, so it
+        // can differ from performCalculation in the last few bits.
+        double energy = statistics->getBarkEnergy();
+        value = 0;
+        
+        if (energy)
+            value = statistics->getBarkMoment() / energy;
+        
+        return true;
+    }
+    
     const char* SpectralCentroid::toString() {
         return "SpectralCentroid";
     }
@@ -25,8 +25,9 @@
 namespace Sirens {
     class SpectralCentroid : public Feature {
     private:        
-        double* barkWeights;
-        double* barkUnits;
+        // Shared tables from TableCache.
+        const double* barkWeights;
+        const double* barkUnits;
         
         int spectrumSize, sampleRate;
         
@@ -35,11 +36,12 @@ namespace Sirens {
         
     public:
         SpectralCentroid(
-            int history_size = 1, 
+            int history_size = 0, 
             int spectrum_size = 1024, 
             int sample_rate = 44100
         );
         
+        SpectralCentroid(const SpectralCentroid& other);
         ~SpectralCentroid();
         
         void setSpectrumSize(int spectrum_size);
@@ -50,6 +52,10 @@ namespace Sirens {
         
         virtual void performCalculation();
         virtual const char* toString();
+        virtual Feature* clone() {return new SpectralCentroid(*this);}
+        
+        virtual bool configureStatistics(SpectralStatistics* statistics);
+        virtual bool performFusedCalculation(SpectralStatistics* statistics);
     };
 }
 
@@ -23,6 +23,7 @@
 using namespace std;
 
 #include "math_support.h"
+#include "SpectralStatistics.h"
 
 namespace Sirens {
     void SpectralSparsity::performCalculation() {
@@ -43,6 +44,20 @@ namespace Sirens {
             value = max / sum;
     }
 
+    bool SpectralSparsity::configureStatistics(SpectralStatistics* statistics) {
+        return true;
+    }
+    
+    bool SpectralSparsity::performFusedCalculation(SpectralStatistics* statistics) {
+        double sum = statistics->getSum();
+        value = 0;
+        
+        if (sum)
+            value = statistics->getMax() / sum;
+        
+        return true;
+    }
+    
     const char* SpectralSparsity::toString() {
         return "SpectralSparsity";
     }
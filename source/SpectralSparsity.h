@@ -28,10 +28,14 @@ using namespace std;
 namespace Sirens {
     class SpectralSparsity : public Feature {
     public: 
-        SpectralSparsity(int history_size = 1) : Feature(history_size) {}
+        SpectralSparsity(int history_size = 0) : Feature(history_size) {}
         
         virtual void performCalculation();
         virtual const char* toString();
+        virtual Feature* clone() {return new SpectralSparsity(*this);}
+        
+        virtual bool configureStatistics(SpectralStatistics* statistics);
+        virtual bool performFusedCalculation(SpectralStatistics* statistics);
     };
 }
 
@@ -0,0 +1,306 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SpectralStatistics.h"
+
+#include "math_support.h"
+#include "SlidingMaximum.h"
+#include "TableCache.h"
+
+namespace Sirens {
+    SpectralStatistics::SpectralStatistics() {
+        spectrumSize = 0;
+        
+        barkRequested = melRequested = peaksRequested = false;
+        barkEnabled = melEnabled = peaksEnabled = false;
+        
+        barkSpectrumSize = barkSampleRate = 0;
+        barkUnits = NULL;
+        barkWeights = NULL;
+        barkEnergy = barkMoment = 0;
+        
+        melSpectrumSize = melSampleRate = melFilterCount = 0;
+        melStart = NULL;
+        melFilters = NULL;
+        melWeights = NULL;
+        melBands = NULL;
+        
+        peakMinIndex = peakMaxIndex = peakHalfWindow = 0;
+        peakIndices = NULL;
+        peakMagnitudes = NULL;
+        peakWindow = NULL;
+        peakCount = 0;
+        maxPeakMagnitude = 0;
+        
+        sum = max = 0;
+    }
+    
+    SpectralStatistics::~SpectralStatistics() {
+        freeBark();
+        freeMel();
+        freePeaks();
+    }
+    
+    void SpectralStatistics::freeBark() {
+        TableCache::release(barkUnits);
+        TableCache::release(barkWeights);
+        
+        barkUnits = NULL;
+        barkWeights = NULL;
+    }
+    
+    void SpectralStatistics::freeMel() {
+        delete [] melStart;
+        delete [] melFilters;
+        delete [] melWeights;
+        delete [] melBands;
+        
+        melStart = NULL;
+        melFilters = NULL;
+        melWeights = NULL;
+        melBands = NULL;
+    }
+    
+    void SpectralStatistics::freePeaks() {
+        delete [] peakIndices;
+        delete [] peakMagnitudes;
+        delete [] peakWindow;
+        
+        peakIndices = NULL;
+        peakMagnitudes = NULL;
+        peakWindow = NULL;
+    }
+    
+    /*-----------*
+     * Requests. *
+     *-----------*/
+    
+    void SpectralStatistics::requestBarkMoments(
+        int spectrum_size, 
+        int sample_rate
+    ) {
+        if (barkRequested)
+            return;
+        
+        barkRequested = true;
+        
+        if (
+            barkUnits == NULL || 
+            spectrum_size != barkSpectrumSize || 
+            sample_rate != barkSampleRate
+        ) {
+            freeBark();
+            
+            barkSpectrumSize = spectrum_size;
+            barkSampleRate = sample_rate;
+            barkUnits = TableCache::acquireBarkUnits(spectrum_size, sample_rate);
+            barkWeights = TableCache::acquireBarkWeights(spectrum_size, sample_rate);
+        }
+    }
+    
+    void SpectralStatistics::requestMelBands(
+        int spectrum_size, 
+        int sample_rate, 
+        int filters
+    ) {
+        if (melRequested)
+            return;
+        
+        melRequested = true;
+        
+        if (
+            melStart == NULL || 
+            spectrum_size != melSpectrumSize || 
+            sample_rate != melSampleRate || 
+            filters != melFilterCount
+        ) {
+            freeMel();
+            
+            melSpectrumSize = spectrum_size;
+            melSampleRate = sample_rate;
+            melFilterCount = filters;
+            
+            // Compress the dense filter bank to its nonzero weights by bin.
+            const double* filter_bank = TableCache::acquireMelFilterBank(
+                filters, 
+                spectrum_size, 
+                sample_rate
+            );
+            
+            int nonzero = 0;
+            
+            for (int i = 0; i < filters * spectrum_size; i++) {
+                if (filter_bank[i] != 0)
+                    nonzero ++;
+            }
+            
+            melStart = new int[spectrum_size + 1];
+            melFilters = new int[nonzero];
+            melWeights = new double[nonzero];
+            melBands = new double[filters];
+            
+            int entry = 0;
+            
+            for (int j = 0; j < spectrum_size; j++) {
+                melStart[j] = entry;
+                
+                for (int i = 0; i < filters; i++) {
+                    if (filter_bank[(i * spectrum_size) + j] != 0) {
+                        melFilters[entry] = i;
+                        melWeights[entry] = filter_bank[(i * spectrum_size) + j];
+                        entry ++;
+                    }
+                }
+            }
+            
+            melStart[spectrum_size] = entry;
+            
+            for (int i = 0; i < filters; i++)
+                melBands[i] = 0;
+            
+            TableCache::release(filter_bank);
+        }
+    }
+    
+    void SpectralStatistics::requestPeaks(
+        int min_index, 
+        int max_index, 
+        int half_window
+    ) {
+        if (peaksRequested)
+            return;
+        
+        peaksRequested = true;
+        
+        if (
+            peakWindow == NULL || 
+            min_index != peakMinIndex || 
+            max_index != peakMaxIndex || 
+            half_window != peakHalfWindow
+        ) {
+            freePeaks();
+            
+            peakMinIndex = min_index;
+            peakMaxIndex = max_index;
+            peakHalfWindow = half_window;
+            
+            int range = maximum(max_index - min_index, 1);
+            
+            peakIndices = new int[range];
+            peakMagnitudes = new double[range];
+            peakWindow = new int[range];
+        }
+    }
+    
+    bool SpectralStatistics::hasBarkMoments(int spectrum_size, int sample_rate) {
+        return barkEnabled && 
+            spectrum_size == barkSpectrumSize && 
+            sample_rate == barkSampleRate;
+    }
+    
+    bool SpectralStatistics::hasMelBands(
+        int spectrum_size, 
+        int sample_rate, 
+        int filters
+    ) {
+        return melEnabled && 
+            spectrum_size == melSpectrumSize && 
+            sample_rate == melSampleRate && 
+            filters == melFilterCount;
+    }
+    
+    bool SpectralStatistics::hasPeaks(
+        int min_index, 
+        int max_index, 
+        int half_window
+    ) {
+        return peaksEnabled && 
+            min_index == peakMinIndex && 
+            max_index == peakMaxIndex && 
+            half_window == peakHalfWindow;
+    }
+    
+    /*--------------*
+     * Calculation. *
+     *--------------*/
+    
+    void SpectralStatistics::calculate(CircularArray* spectrum) {
+        spectrumSize = spectrum->getSize();
+        
+        barkEnabled = barkRequested && barkSpectrumSize == spectrumSize;
+        melEnabled = melRequested && melSpectrumSize == spectrumSize;
+        peaksEnabled = peaksRequested && 
+            peakMinIndex >= 0 && 
+            peakMaxIndex <= spectrumSize;
+        
+        barkRequested = melRequested = peaksRequested = false;
+        
+        sum = max = 0;
+        barkEnergy = barkMoment = 0;
+        peakCount = 0;
+        maxPeakMagnitude = 0;
+        
+        if (melEnabled) {
+            for (int i = 0; i < melFilterCount; i++)
+                melBands[i] = 0;
+        }
+        
+        // Peaks are bins k in [peakMinIndex + peakHalfWindow, peakMaxIndex -
+        // peakHalfWindow) that are the maximum of [k - peakHalfWindow, k +
+        // peakHalfWindow].
+        SlidingMaximum window(peakWindow, peakMinIndex, peakHalfWindow);
+        
+        double* data = spectrum->getData();
+        
+        for (int j = 0; j < spectrumSize; j++) {
+            double x = data[j];
+            
+            max = maximum(x, max);
+            sum += x;
+            
+            if (barkEnabled && j > 0) {
+                double energy = x * x * barkWeights[j - 1];
+                
+                barkEnergy += energy;
+                barkMoment += energy * barkUnits[j];
+            }
+            
+            if (melEnabled) {
+                for (int k = melStart[j]; k < melStart[j + 1]; k++)
+                    melBands[melFilters[k]] += melWeights[k] * x;
+            }
+            
+            if (
+                peaksEnabled && 
+                j >= peakMinIndex && 
+                j < peakMaxIndex && 
+                window.add(data, j)
+            ) {
+                int k = j - peakHalfWindow;
+                
+                peakIndices[peakCount] = k;
+                peakMagnitudes[peakCount] = data[k];
+                peakCount ++;
+                
+                if (maxPeakMagnitude < data[k])
+                    maxPeakMagnitude = data[k];
+            }
+        }
+    }
+}
@@ -0,0 +1,119 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_SPECTRALSTATISTICS_H
+#define SIRENS_SPECTRALSTATISTICS_H
+
+#include "CircularArray.h"
+
+/*
+    SpectralStatistics - computes every per-frame quantity the spectral
+        features need in a single sweep over the spectrum, instead of each
+        feature walking the spectrum separately. Used by FeatureSet when the
+        fused spectral pass is enabled.
+        
+    Before each frame, features request the quantities they need (see
+    Feature::requestStatistics). Only the first request of each kind per frame
+    configures the engine; a feature whose request conflicts with another's
+    can check the has*() methods and fall back to its own calculation.
+    
+    Always computed:
+        sum and maximum of the magnitudes (SpectralSparsity).
+    On request:
+        bark moments: sum of x^2 * bark bandwidth, and the same weighted by
+            bark frequency, over bins 1 and up (SpectralCentroid).
+        mel bands: energy in each triangular mel filter (TransientIndex).
+        peaks: bins that are the maximum of the search region centered on
+            them, within a range of bins (Harmonicity).
+*/
+
+namespace Sirens {
+    class SpectralStatistics {
+    private:
+        int spectrumSize;
+        
+        // Whether each quantity has been requested during the current frame.
+        bool barkRequested, melRequested, peaksRequested;
+        
+        // Bark moments.
+        bool barkEnabled;
+        int barkSpectrumSize, barkSampleRate;
+        const double* barkUnits;
+        const double* barkWeights;
+        double barkEnergy, barkMoment;
+        
+        // Mel bands. The filter bank is stored sparsely by bin: the weights
+        // of bin j are melWeights[melStart[j] ... melStart[j + 1] - 1], for
+        // filters melFilters[...]. Each bin belongs to at most two filters.
+        bool melEnabled;
+        int melSpectrumSize, melSampleRate, melFilterCount;
+        int* melStart;
+        int* melFilters;
+        double* melWeights;
+        double* melBands;
+        
+        // Peaks.
+        bool peaksEnabled;
+        int peakMinIndex, peakMaxIndex, peakHalfWindow;
+        int* peakIndices;
+        double* peakMagnitudes;
+        int* peakWindow;
+        int peakCount;
+        double maxPeakMagnitude;
+        
+        // Sum and maximum.
+        double sum, max;
+        
+        void freeBark();
+        void freeMel();
+        void freePeaks();
+        
+    public:
+        SpectralStatistics();
+        ~SpectralStatistics();
+        
+        // Requests. Tables are only rebuilt when parameters change.
+        void requestBarkMoments(int spectrum_size, int sample_rate);
+        void requestMelBands(int spectrum_size, int sample_rate, int filters);
+        void requestPeaks(int min_index, int max_index, int half_window);
+        
+        bool hasBarkMoments(int spectrum_size, int sample_rate);
+        bool hasMelBands(int spectrum_size, int sample_rate, int filters);
+        bool hasPeaks(int min_index, int max_index, int half_window);
+        
+        // Sweep the spectrum once. Ends the current frame's requests.
+        void calculate(CircularArray* spectrum);
+        
+        // Results.
+        double getSum() {return sum;}
+        double getMax() {return max;}
+        
+        double getBarkEnergy() {return barkEnergy;}
+        double getBarkMoment() {return barkMoment;}
+        
+        double* getMelBands() {return melBands;}
+        
+        int getPeakCount() {return peakCount;}
+        int* getPeakIndices() {return peakIndices;}
+        double* getPeakMagnitudes() {return peakMagnitudes;}
+        double getMaxPeakMagnitude() {return maxPeakMagnitude;}
+    };
+}
+
+#endif
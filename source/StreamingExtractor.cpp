@@ -0,0 +1,282 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StreamingExtractor.h"
+
+#include <cmath>
+using namespace std;
+
+#include "math_support.h"
+#include "Instrumentation.h"
+
+namespace Sirens {
+    StreamingExtractor::StreamingExtractor(int sample_rate, int channels_in) {
+        sampleRate = sample_rate;
+        channels = channels_in;
+        frameLength = 0.04;
+        hopLength = 0.02;
+        channelOption = 0;
+        
+        featureSet = NULL;
+        frameCallback = NULL;
+        callbackData = NULL;
+        
+        initialized = false;
+        
+        sampleArray = NULL;
+        windowedArray = NULL;
+        spectrumArray = NULL;
+        window = NULL;
+        fft = NULL;
+        frameValues = NULL;
+        featureCount = 0;
+        
+        reset();
+    }
+    
+    StreamingExtractor::~StreamingExtractor() {
+        freeMemory();
+    }
+    
+    void StreamingExtractor::freeMemory() {
+        // The FFT plan refers to the windowed array, so it goes first.
+        delete fft;
+        delete sampleArray;
+        delete windowedArray;
+        delete spectrumArray;
+        delete [] window;
+        delete [] frameValues;
+        
+        fft = NULL;
+        sampleArray = NULL;
+        windowedArray = NULL;
+        spectrumArray = NULL;
+        window = NULL;
+        frameValues = NULL;
+    }
+    
+    void StreamingExtractor::initialize() {
+        freeMemory();
+        
+        sampleArray = new CircularArray(getSamplesPerFrame());
+        windowedArray = new CircularArray(getSamplesPerFrame(), getFFTSize());
+        spectrumArray = new CircularArray(getSpectrumSize());
+        window = create_hamming_window(getSamplesPerFrame());
+        fft = new FFT(getFFTSize(), windowedArray->getData());
+        
+        features.clear();
+        
+        if (featureSet != NULL)
+            features = featureSet->getFeatures();
+        
+        featureCount = features.size();
+        frameValues = new double[maximum(featureCount, 1)];
+        
+        reset();
+        
+        initialized = true;
+    }
+    
+    void StreamingExtractor::reset() {
+        channel = 0;
+        channelSum = 0;
+        hopSamples = 0;
+        frameNumber = 0;
+        
+        // Start the next frame from an empty sample buffer.
+        if (sampleArray != NULL)
+            sampleArray->clear();
+    }
+    
+    /*---------------------*
+     * Stream information. *
+     *---------------------*/
+    
+    int StreamingExtractor::getSampleRate() {
+        return sampleRate;
+    }
+    
+    int StreamingExtractor::getChannels() {
+        return channels;
+    }
+    
+    double StreamingExtractor::getHopLength() {
+        return hopLength;
+    }
+    
+    double StreamingExtractor::getFrameLength() {
+        return frameLength;
+    }
+    
+    void StreamingExtractor::setHopLength(double hop_length) {
+        hopLength = hop_length;
+        
+        initialized = false;
+    }
+    
+    void StreamingExtractor::setFrameLength(double frame_length) {
+        frameLength = frame_length;
+        
+        initialized = false;
+    }
+    
+    void StreamingExtractor::setChannelOption(int channel_option) {
+        if (channel_option > channels || channel_option < 0)
+            channelOption = 0;
+        else
+            channelOption = channel_option;
+        
+        initialized = false;
+    }
+    
+    int StreamingExtractor::getChannelOption() {
+        return channelOption;
+    }
+    
+    int StreamingExtractor::getSamplesPerFrame() {
+        return int(frameLength * double(sampleRate));
+    }
+    
+    int StreamingExtractor::getSamplesPerHop() {
+        return int(hopLength * double(sampleRate));
+    }
+    
+    int StreamingExtractor::getFFTSize() {
+        return next_pow(getSamplesPerFrame(), 2);
+    }
+    
+    int StreamingExtractor::getSpectrumSize() {
+        return getFFTSize() / 2 + 1;
+    }
+    
+    /*-----------*
+     * Features. *
+     *-----------*/
+    
+    FeatureSet* StreamingExtractor::getFeatureSet() {
+        return featureSet;
+    }
+    
+    void StreamingExtractor::setFeatureSet(FeatureSet* feature_set) {
+        featureSet = feature_set;
+        
+        initialized = false;
+    }
+    
+    void StreamingExtractor::setFrameCallback(
+        void(* callback)(long, double*, int, void*), 
+        void* data
+    ) {
+        frameCallback = callback;
+        callbackData = data;
+    }
+    
+    long StreamingExtractor::getFrameNumber() {
+        return frameNumber;
+    }
+    
+    /*-------------*
+     * Extraction. *
+     *-------------*/
+    
+    void StreamingExtractor::addSamples(const double* samples, int sample_count) {
+        if (!initialized)
+            initialize();
+        
+        for (int i = 0; i < sample_count; i++)
+            addSample(samples[i]);
+    }
+    
+    void StreamingExtractor::addSamples(const float* samples, int sample_count) {
+        if (!initialized)
+            initialize();
+        
+        for (int i = 0; i < sample_count; i++)
+            addSample(samples[i]);
+    }
+    
+    void StreamingExtractor::addSample(double sample) {
+        // Mix the channels down the same way Sound::extractFeatures does.
+        if (channelOption == 0)
+            channelSum += sample;
+        else if (channel == channelOption - 1)
+            channelSum = sample;
+        
+        channel ++;
+        
+        if (channel < channels)
+            return;
+        
+        double mixed_sample = channelOption ? channelSum : channelSum / double(channels);
+        
+        channel = 0;
+        channelSum = 0;
+        
+        sampleArray->addValue(mixed_sample);
+        hopSamples ++;
+        
+        // The first hop or two will not necessarily be a full frame's worth
+        // of data.
+        if (hopSamples >= getSamplesPerHop()) {
+            hopSamples = 0;
+            
+            if (sampleArray->getSize() == sampleArray->getMaxSize())
+                processFrame();
+        }
+    }
+    
+    void StreamingExtractor::processFrame() {
+        SIRENS_TIMER("extract:stream_frame");
+        
+        if (featureSet != NULL) {
+            // Calculate sample features.
+            featureSet->calculateSampleFeatures(sampleArray);
+            
+            // Window the time-domain signal for STFT.
+            int samples_per_frame = getSamplesPerFrame();
+            
+            for (int i = 0; i < samples_per_frame; i++)
+                windowedArray->addValue(sampleArray->getValue(i) * window[i]);
+            
+            // Perform STFT.
+            fft->calculate();
+            
+            fftw_complex* output = fft->getOutput();
+            
+            for (int i = 0; i < fft->getOutputSize(); i++) {
+                double first = output[i][0];
+                double second = output[i][1];
+                
+                spectrumArray->addValue(sqrt(first * first + second * second));
+            }
+            
+            // Calculate spectral features.
+            featureSet->calculateSpectralFeatures(spectrumArray);
+            
+            // Collect the frame's values, in the feature set's order.
+            for (int i = 0; i < featureCount; i++)
+                frameValues[i] = features[i]->getValue();
+        }
+        
+        if (frameCallback != NULL)
+            frameCallback(frameNumber, frameValues, featureCount, callbackData);
+        
+        frameNumber ++;
+    }
+}
@@ -0,0 +1,142 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_STREAMINGEXTRACTOR_H
+#define SIRENS_STREAMINGEXTRACTOR_H
+
+#include "FeatureSet.h"
+#include "CircularArray.h"
+#include "FFT.h"
+
+/*
+    StreamingExtractor - extracts features from a live stream of samples, such
+        as a microphone feed, rather than a file. Interleaved sample buffers of
+        any size are pushed with addSamples, and the extractor does the same
+        framing, channel mixing and STFT as Sound::extractFeatures.
+    
+    Each time a hop's worth of samples completes a full frame, the features in
+    the FeatureSet are calculated and the frame's feature values are passed
+    to the frame callback, in the order of FeatureSet::getFeatures(). So a
+    frame is emitted at most one hop after its last sample arrives.
+    
+    Buffers are allocated when the first samples arrive (or after a parameter
+    changes), so the steady state does no allocation. For that to hold for
+    the features too, give them a history bound (the history_size constructor
+    argument), since by default their histories keep every frame, and use
+    FeatureSet::setThreaded(false), since threaded features start a new
+    thread every frame.
+    
+    Features that depend on the spectrum size or sample rate should be
+    constructed with getSpectrumSize() and getSampleRate(). Call
+    setFeatureSet again after adding features to the feature set.
+*/
+
+namespace Sirens {
+    class StreamingExtractor {
+    private:
+        int sampleRate, channels;
+        double hopLength, frameLength;
+        
+        // 0 averages all channels; n uses only the nth channel. Out of range
+        // options average all channels, as in Sound.
+        int channelOption;
+        
+        FeatureSet* featureSet;
+        
+        void(* frameCallback)(long, double*, int, void*);
+        void* callbackData;
+        
+        bool initialized;
+        
+        // Samples of the current frame, the windowed and zero-padded frame for
+        // the STFT, and the spectrum magnitudes.
+        CircularArray* sampleArray;
+        CircularArray* windowedArray;
+        CircularArray* spectrumArray;
+        double* window;
+        FFT* fft;
+        
+        // The feature set's features as of initialization, and the values of
+        // the current frame's features.
+        vector<Feature*> features;
+        double* frameValues;
+        int featureCount;
+        
+        // Position within the current interleaved sample frame, and the sum
+        // of its channels so far.
+        int channel;
+        double channelSum;
+        
+        // Samples received since the last hop.
+        int hopSamples;
+        
+        long frameNumber;
+        
+        void initialize();
+        void freeMemory();
+        
+        void addSample(double sample);
+        void processFrame();
+        
+    public:
+        StreamingExtractor(int sample_rate = 44100, int channels_in = 1);
+        ~StreamingExtractor();
+        
+        // Stream information.
+        int getSampleRate();
+        int getChannels();
+        double getHopLength();
+        double getFrameLength();
+        void setHopLength(double hop_length);
+        void setFrameLength(double frame_length);
+        void setChannelOption(int channel_option);
+        int getChannelOption();
+        
+        // Calculated stream information.
+        int getSamplesPerFrame();
+        int getSamplesPerHop();
+        int getFFTSize();
+        int getSpectrumSize();
+        
+        // Features.
+        FeatureSet* getFeatureSet();
+        void setFeatureSet(FeatureSet* feature_set);
+        
+        // Called once per frame with the frame number, the features' values,
+        // the number of features and data.
+        void setFrameCallback(
+            void(* callback)(long, double*, int, void*), 
+            void* data = NULL
+        );
+        
+        // Adds interleaved samples. sample_count counts every channel's
+        // samples, and need not be a whole number of sample frames.
+        void addSamples(const double* samples, int sample_count);
+        void addSamples(const float* samples, int sample_count);
+        
+        // Drops any buffered samples and restarts frame numbering. Feature
+        // state, such as history, is left alone.
+        void reset();
+        
+        // Number of frames emitted so far.
+        long getFrameNumber();
+    };
+}
+
+#endif
@@ -0,0 +1,186 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TableCache.h"
+
+#include <map>
+#include <pthread.h>
+using namespace std;
+
+#include "math_support.h"
+
+namespace Sirens {
+    enum TableType {
+        BARK_UNITS,
+        BARK_WEIGHTS,
+        MEL_FILTER_BANK,
+        DCT_MATRIX
+    };
+    
+    // Everything a table depends on. Unused parameters are 0.
+    struct TableKey {
+        int type;
+        int spectrumSize, sampleRate, filters, mels;
+        
+        bool operator<(const TableKey& other) const {
+            if (type != other.type)
+                return type < other.type;
+            else if (spectrumSize != other.spectrumSize)
+                return spectrumSize < other.spectrumSize;
+            else if (sampleRate != other.sampleRate)
+                return sampleRate < other.sampleRate;
+            else if (filters != other.filters)
+                return filters < other.filters;
+            else
+                return mels < other.mels;
+        }
+    };
+    
+    struct TableEntry {
+        double* table;
+        int references;
+    };
+    
+    // Shared by every thread, guarded by mutex. The maps are never
+    // destroyed, so features that outlive static destruction can still
+    // release their tables.
+    static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    static map<TableKey, TableEntry>& tables = *new map<TableKey, TableEntry>();
+    static map<const double*, TableKey>& tableKeys = *new map<const double*, TableKey>();
+    
+    static TableKey make_key(
+        int type, 
+        int spectrum_size, 
+        int sample_rate, 
+        int filters, 
+        int mels
+    ) {
+        TableKey key;
+        key.type = type;
+        key.spectrumSize = spectrum_size;
+        key.sampleRate = sample_rate;
+        key.filters = filters;
+        key.mels = mels;
+        
+        return key;
+    }
+    
+    static double* create_table(const TableKey& key) {
+        switch (key.type) {
+            case BARK_UNITS:
+                return create_bark_units(key.spectrumSize, key.sampleRate);
+                
+            case BARK_WEIGHTS: {
+                double* bark_units = create_bark_units(key.spectrumSize, key.sampleRate);
+                double* bark_weights = create_bark_weights(bark_units, key.spectrumSize);
+                
+                delete [] bark_units;
+                
+                return bark_weights;
+            }
+            
+            case MEL_FILTER_BANK:
+                return create_mel_filter_bank(key.filters, key.spectrumSize, key.sampleRate);
+                
+            case DCT_MATRIX:
+                return create_dct_matrix(key.filters, key.mels);
+        }
+        
+        return NULL;
+    }
+    
+    // Tables are built while holding the lock. This only happens when
+    // features are initialized, so contention doesn't matter.
+    static const double* acquire(const TableKey& key) {
+        pthread_mutex_lock(&mutex);
+        
+        map<TableKey, TableEntry>::iterator entry = tables.find(key);
+        
+        if (entry == tables.end()) {
+            TableEntry new_entry;
+            new_entry.table = create_table(key);
+            new_entry.references = 0;
+            
+            entry = tables.insert(make_pair(key, new_entry)).first;
+            tableKeys[new_entry.table] = key;
+        }
+        
+        entry->second.references ++;
+        
+        const double* table = entry->second.table;
+        
+        pthread_mutex_unlock(&mutex);
+        
+        return table;
+    }
+    
+    const double* TableCache::acquireBarkUnits(int spectrum_size, int sample_rate) {
+        return acquire(make_key(BARK_UNITS, spectrum_size, sample_rate, 0, 0));
+    }
+    
+    const double* TableCache::acquireBarkWeights(int spectrum_size, int sample_rate) {
+        return acquire(make_key(BARK_WEIGHTS, spectrum_size, sample_rate, 0, 0));
+    }
+    
+    const double* TableCache::acquireMelFilterBank(
+        int filters, 
+        int spectrum_size, 
+        int sample_rate
+    ) {
+        return acquire(make_key(MEL_FILTER_BANK, spectrum_size, sample_rate, filters, 0));
+    }
+    
+    const double* TableCache::acquireDCTMatrix(int filters, int mels) {
+        return acquire(make_key(DCT_MATRIX, 0, 0, filters, mels));
+    }
+    
+    void TableCache::release(const double* table) {
+        if (table == NULL)
+            return;
+        
+        pthread_mutex_lock(&mutex);
+        
+        map<const double*, TableKey>::iterator key = tableKeys.find(table);
+        
+        if (key != tableKeys.end()) {
+            map<TableKey, TableEntry>::iterator entry = tables.find(key->second);
+            
+            entry->second.references --;
+            
+            if (entry->second.references == 0) {
+                delete [] entry->second.table;
+                
+                tables.erase(entry);
+                tableKeys.erase(key);
+            }
+        }
+        
+        pthread_mutex_unlock(&mutex);
+    }
+    
+    int TableCache::getTableCount() {
+        pthread_mutex_lock(&mutex);
+        
+        int table_count = tables.size();
+        
+        pthread_mutex_unlock(&mutex);
+        
+        return table_count;
+    }
+}
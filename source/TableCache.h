@@ -0,0 +1,65 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_TABLECACHE_H
+#define SIRENS_TABLECACHE_H
+
+/*
+    TableCache - process-wide cache of the read-only lookup tables that
+        spectral features build at initialization (bark units and weights, mel
+        filter banks and DCT matrices), keyed by the parameters they depend
+        on. Features with matching parameters share one copy of each table,
+        so memory and initialization time don't grow with the number of
+        feature instances.
+    
+    Tables are reference counted: every acquire must be matched by a release,
+    and a table is freed when its last user releases it. All methods are
+    thread-safe. Tables must not be modified.
+    
+    Sizes, as from the corresponding math_support functions:
+        bark units: spectrum_size
+        bark weights: spectrum_size - 1
+        mel filter bank: filters * spectrum_size (row-major by filter)
+        DCT matrix: mels * filters (row-major by mel)
+*/
+
+namespace Sirens {
+    class TableCache {
+    public:
+        static const double* acquireBarkUnits(int spectrum_size, int sample_rate);
+        static const double* acquireBarkWeights(int spectrum_size, int sample_rate);
+        
+        static const double* acquireMelFilterBank(
+            int filters, 
+            int spectrum_size, 
+            int sample_rate
+        );
+        
+        static const double* acquireDCTMatrix(int filters, int mels);
+        
+        // Releases a table returned by one of the acquire methods. NULL is
+        // ignored.
+        static void release(const double* table);
+        
+        // Number of distinct tables currently cached.
+        static int getTableCount();
+    };
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include "TemporalSparsity.h"
 
 #include "math_support.h"
+#include "SampleStatistics.h"
 
 namespace Sirens {
     TemporalSparsity::TemporalSparsity(
@@ -27,12 +28,26 @@ namespace Sirens {
         int window_size
     ) : Feature(history_size) {
         rmsWindow = NULL;
+        maxValues = NULL;
+        maxFrames = NULL;
         
         setWindowSize(window_size);
     }
 
+    TemporalSparsity::TemporalSparsity(
+        const TemporalSparsity& other
+    ) : Feature(other) {
+        rmsWindow = NULL;
+        maxValues = NULL;
+        maxFrames = NULL;
+        
+        setWindowSize(other.rmsWindow->getMaxSize());
+    }
+
     TemporalSparsity::~TemporalSparsity() {
         delete rmsWindow;
+        delete [] maxValues;
+        delete [] maxFrames;
     }
     
     void TemporalSparsity::setWindowSize(int window_size) { 
@@ -46,30 +61,158 @@ namespace Sirens {
         }
         
         rmsWindow = new_window;
+        
+        delete [] maxValues;
+        delete [] maxFrames;
+        
+        maxValues = new double[window_size];
+        maxFrames = new long[window_size];
+        
+        rebuildStatistics();
+    }
+    
+    void TemporalSparsity::resetState() {
+        rmsWindow->clear();
+        
+        rebuildStatistics();
+    }
+    
+    // The sum is kept as it is rather than rebuilt, as it is only
+    // resynchronized once per window.
+    void TemporalSparsity::saveRunningState(Checkpoint* checkpoint) {
+        rmsWindow->saveState(checkpoint);
+        
+        checkpoint->writeDouble(rmsSum);
+        checkpoint->writeInt(framesSinceResync);
+        checkpoint->writeInt(maxFront);
+        checkpoint->writeInt(maxCount);
+        checkpoint->writeLong(rmsFrame);
+        checkpoint->writeDoubles(maxValues, rmsWindow->getMaxSize());
+        
+        for (int i = 0; i < rmsWindow->getMaxSize(); i++)
+            checkpoint->writeLong(maxFrames[i]);
+    }
+    
+    void TemporalSparsity::loadRunningState(Checkpoint* checkpoint) {
+        rmsWindow->loadState(checkpoint);
+        
+        rmsSum = checkpoint->readDouble();
+        framesSinceResync = checkpoint->readInt();
+        maxFront = checkpoint->readInt();
+        maxCount = checkpoint->readInt();
+        rmsFrame = checkpoint->readLong();
+        
+        if (maxFront < 0 || maxFront >= rmsWindow->getMaxSize() || maxCount < 0 || maxCount > rmsWindow->getMaxSize())
+            throw CheckpointException();
+        
+        checkpoint->readDoubles(maxValues, rmsWindow->getMaxSize());
+        
+        for (int i = 0; i < rmsWindow->getMaxSize(); i++)
+            maxFrames[i] = checkpoint->readLong();
     }
     
     int TemporalSparsity::getWindowSize() {
         return rmsWindow->getMaxSize();
     }
     
-    void TemporalSparsity::performCalculation() {
-        double rms = signal_rms(input);
+    // Recompute the running sum and maximum deque from scratch.
+    void TemporalSparsity::rebuildStatistics() {
+        int window_size = rmsWindow->getMaxSize();
+        
+        rmsSum = 0;
+        framesSinceResync = 0;
+        maxFront = 0;
+        maxCount = 0;
+        rmsFrame = rmsWindow->getSize();
+        
+        double* rms_item = rmsWindow->getData();
+        
+        for (int i = 0; i < rmsWindow->getSize(); i++) {
+            rmsSum += (*rms_item);
+            rms_item ++;
+        }
+        
+        for (int i = 0; i < rmsWindow->getSize(); i++) {
+            double rms = rmsWindow->getValue(i);
+            
+            while (
+                maxCount && 
+                maxValues[(maxFront + maxCount - 1) % window_size] <= rms
+            )
+                maxCount --;
+            
+            maxValues[(maxFront + maxCount) % window_size] = rms;
+            maxFrames[(maxFront + maxCount) % window_size] = 
+                rmsFrame - rmsWindow->getSize() + i;
+            maxCount ++;
+        }
+    }
+    
+    void TemporalSparsity::pushRMS(double rms) {
+        int window_size = rmsWindow->getMaxSize();
+        
+        // The oldest value falls out of the window once it is full.
+        if (rmsWindow->getSize() == window_size)
+            rmsSum -= rmsWindow->getValue(0);
         
         rmsWindow->addValue(rms);
+        rmsSum += rms;
         
-        double max = 0;
-        double sum = 0;
-        value=0;
+        // Expire the maximum if it has slid out of the window.
+        if (maxCount && maxFrames[maxFront] <= rmsFrame - window_size) {
+            maxFront = (maxFront + 1) % window_size;
+            maxCount --;
+        }
         
-        double* rms_item = rmsWindow->getData();
-        int rms_size = rmsWindow->getSize();
+        // Older values no larger than the new one can never be the maximum.
+        while (
+            maxCount && 
+            maxValues[(maxFront + maxCount - 1) % window_size] <= rms
+        )
+            maxCount --;
         
-        for (int i = 0; i < rms_size; i++) {
-            max = maximum(max, (*rms_item));
-            sum += (*rms_item);
+        maxValues[(maxFront + maxCount) % window_size] = rms;
+        maxFrames[(maxFront + maxCount) % window_size] = rmsFrame;
+        maxCount ++;
+        
+        rmsFrame ++;
+        framesSinceResync ++;
+        
+        // Resynchronize the sum once per window, keeping this amortized O(1).
+        if (framesSinceResync >= window_size) {
+            double* rms_item = rmsWindow->getData();
             
-            rms_item ++;
+            rmsSum = 0;
+            
+            for (int i = 0; i < rmsWindow->getSize(); i++) {
+                rmsSum += (*rms_item);
+                rms_item ++;
+            }
+            
+            framesSinceResync = 0;
         }
+    }
+    
+    void TemporalSparsity::performCalculation() {
+        pushRMS(signal_rms(input));
+        calculateSparsity();
+    }
+    
+    bool TemporalSparsity::configureSampleStatistics(SampleStatistics* statistics) {
+        return true;
+    }
+    
+    bool TemporalSparsity::performFusedSampleCalculation(SampleStatistics* statistics) {
+        pushRMS(statistics->getRMS());
+        calculateSparsity();
+        
+        return true;
+    }
+    
+    void TemporalSparsity::calculateSparsity() {
+        double max = maximum(0.0, maxValues[maxFront]);
+        double sum = rmsSum;
+        value = 0;
         
         if (sum) {
             if (rmsWindow->getSize() >= rmsWindow->getMaxSize())
@@ -30,8 +30,36 @@ namespace Sirens {
     private:
         CircularArray* rmsWindow;
         
+        // Running statistics over rmsWindow, so that each frame costs
+        // amortized O(1) rather than O(window size).
+        
+        // Sum of every RMS value in the window. Resynchronized with an exact
+        // sum once per window length to keep rounding error from drifting.
+        double rmsSum;
+        int framesSinceResync;
+        
+        // Monotonic deque of (value, frame) pairs whose values are strictly
+        // decreasing from front to back. The front is the window maximum.
+        // Stored as a ring buffer of the window size, so no allocation is
+        // done per frame.
+        double* maxValues;
+        long* maxFrames;
+        int maxFront, maxCount;
+        
+        // Number of RMS values added to the window so far.
+        long rmsFrame;
+        
+        void pushRMS(double rms);
+        void rebuildStatistics();
+        void calculateSparsity();
+        
+        virtual void resetState();
+        virtual void saveRunningState(Checkpoint* checkpoint);
+        virtual void loadRunningState(Checkpoint* checkpoint);
+        
     public: 
-        TemporalSparsity(int history_size = 1, int window_size = 50);
+        TemporalSparsity(int history_size = 0, int window_size = 50);
+        TemporalSparsity(const TemporalSparsity& other);
         ~TemporalSparsity();
         
         void setWindowSize(int window_size);
@@ -39,6 +67,10 @@ namespace Sirens {
         
         virtual void performCalculation();
         virtual const char* toString();
+        virtual Feature* clone() {return new TemporalSparsity(*this);}
+        
+        virtual bool configureSampleStatistics(SampleStatistics* statistics);
+        virtual bool performFusedSampleCalculation(SampleStatistics* statistics);
     };
 }
 
@@ -19,6 +19,9 @@
 
 #include "Thread.h"
 
+#include <vector>
+using namespace std;
+
 Thread::Thread() {
 	thread = 0;
 };
@@ -38,3 +41,54 @@ bool Thread::wait() {
 	} else
 		return false;
 }
+
+struct TaskQueue {
+	void (*task)(int, void*);
+	void* data;
+	int count;
+	int next;
+	pthread_mutex_t mutex;
+};
+
+static void* run_queue(void* queue_in) {
+	TaskQueue* queue = (TaskQueue*)queue_in;
+
+	while (true) {
+		pthread_mutex_lock(&queue->mutex);
+		int index = queue->next++;
+		pthread_mutex_unlock(&queue->mutex);
+
+		if (index >= queue->count)
+			break;
+
+		queue->task(index, queue->data);
+	}
+
+	return NULL;
+}
+
+void run_tasks(void (*task)(int, void*), void* data, int count, int threads) {
+	TaskQueue queue;
+	queue.task = task;
+	queue.data = data;
+	queue.count = count;
+	queue.next = 0;
+	pthread_mutex_init(&queue.mutex, NULL);
+
+	if (threads > count)
+		threads = count;
+
+	if (threads <= 1)
+		run_queue(&queue);
+	else {
+		vector<Thread> workers(threads);
+
+		for (int i = 0; i < threads; i++)
+			workers[i].start(run_queue, &queue);
+
+		for (int i = 0; i < threads; i++)
+			workers[i].wait();
+	}
+
+	pthread_mutex_destroy(&queue.mutex);
+}
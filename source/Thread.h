@@ -35,4 +35,8 @@ public:
     bool wait();
 };
 
+// Calls task(index, data) for every index in [0, count), with up to threads
+// threads taking the next index as they finish, and returns when all are done.
+void run_tasks(void (*task)(int, void*), void* data, int count, int threads);
+
 #endif
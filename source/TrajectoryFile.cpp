@@ -0,0 +1,360 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+#include <fstream>
+using namespace std;
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "TrajectoryFile.h"
+#include "string_support.h"
+#include "math_support.h"
+
+namespace Sirens {
+    static const char trajectory_magic[8] = {'S', 'I', 'R', 'E', 'N', 'S', 'T', 'J'};
+    static const uint32_t trajectory_version = 1;
+    static const int header_size = 64;
+    static const int entry_size = 64;
+    static const int name_size = 48;
+
+    TrajectoryFile::TrajectoryFile() {
+        mapping = NULL;
+        mappingSize = 0;
+        valueSize = 8;
+        frameCount = 0;
+        sampleRate = 0;
+        hopSize = 0;
+    }
+
+    TrajectoryFile::~TrajectoryFile() {
+        close();
+    }
+
+    /*----------*
+     * Reading. *
+     *----------*/
+
+    void TrajectoryFile::open(string path) {
+        close();
+
+        int file = ::open(path.c_str(), O_RDONLY);
+
+        if (file < 0)
+            throw TrajectoryFileException();
+
+        struct stat status;
+
+        if (fstat(file, &status) != 0 || status.st_size < header_size) {
+            ::close(file);
+            throw TrajectoryFileException();
+        }
+
+        mappingSize = status.st_size;
+        void* address = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE, file, 0);
+        ::close(file);
+
+        if (address == MAP_FAILED) {
+            mappingSize = 0;
+            throw TrajectoryFileException();
+        }
+
+        mapping = (char*)address;
+
+        uint32_t version, feature_count, value_size;
+        uint64_t frame_count;
+
+        memcpy(&version, mapping + 8, 4);
+        memcpy(&feature_count, mapping + 12, 4);
+        memcpy(&value_size, mapping + 16, 4);
+        memcpy(&frame_count, mapping + 24, 8);
+        memcpy(&sampleRate, mapping + 32, 8);
+        memcpy(&hopSize, mapping + 40, 8);
+
+        // Check the counts against the mapping one factor at a time, so that a
+        // corrupt header can't overflow the expected size and pass.
+        uint64_t available = mappingSize - header_size;
+        uint64_t column_size = frame_count * value_size;
+
+        if (
+            memcmp(mapping, trajectory_magic, 8) != 0 ||
+            version != trajectory_version ||
+            (value_size != 4 && value_size != 8) ||
+            frame_count > 0x7fffffff ||
+            feature_count > available / entry_size ||
+            (column_size > 0 && feature_count > (available - uint64_t(feature_count) * entry_size) / column_size)
+        ) {
+            close();
+            throw TrajectoryFileException();
+        }
+
+        valueSize = value_size;
+        frameCount = frame_count;
+
+        const char* column = mapping + header_size + size_t(feature_count) * entry_size;
+
+        for (int i = 0; i < feature_count; i++) {
+            const char* entry = mapping + header_size + size_t(i) * entry_size;
+            double feature_min, feature_max;
+
+            memcpy(&feature_min, entry + name_size, 8);
+            memcpy(&feature_max, entry + name_size + 8, 8);
+
+            names.push_back(string(entry, strnlen(entry, name_size)));
+            minimums.push_back(feature_min);
+            maximums.push_back(feature_max);
+            columns.push_back(column);
+
+            column += size_t(frameCount) * valueSize;
+        }
+    }
+
+    void TrajectoryFile::close() {
+        if (mapping != NULL)
+            munmap(mapping, mappingSize);
+
+        mapping = NULL;
+        mappingSize = 0;
+        frameCount = 0;
+
+        names.clear();
+        minimums.clear();
+        maximums.clear();
+        columns.clear();
+    }
+
+    bool TrajectoryFile::isOpen() {
+        return mapping != NULL;
+    }
+
+    bool TrajectoryFile::isTrajectoryFile(string path) {
+        char magic[8];
+        ifstream file(path.c_str(), ios::in | ios::binary);
+
+        file.read(magic, 8);
+
+        return file.good() && memcmp(magic, trajectory_magic, 8) == 0;
+    }
+
+    int TrajectoryFile::getFeatureCount() {
+        return names.size();
+    }
+
+    int TrajectoryFile::getFrameCount() {
+        return frameCount;
+    }
+
+    int TrajectoryFile::getValueSize() {
+        return valueSize;
+    }
+
+    double TrajectoryFile::getSampleRate() {
+        return sampleRate;
+    }
+
+    double TrajectoryFile::getHopSize() {
+        return hopSize;
+    }
+
+    string TrajectoryFile::getFeatureName(int feature) {
+        return names[feature];
+    }
+
+    double TrajectoryFile::getMin(int feature) {
+        return minimums[feature];
+    }
+
+    double TrajectoryFile::getMax(int feature) {
+        return maximums[feature];
+    }
+
+    const double* TrajectoryFile::getColumn(int feature) {
+        if (valueSize != 8)
+            return NULL;
+
+        return (const double*)columns[feature];
+    }
+
+    void TrajectoryFile::readColumn(int feature, double* values) {
+        if (valueSize == 8)
+            memcpy(values, columns[feature], frameCount * sizeof(double));
+        else {
+            const float* column = (const float*)columns[feature];
+
+            for (int i = 0; i < frameCount; i++)
+                values[i] = column[i];
+        }
+    }
+
+    void TrajectoryFile::loadFeature(int feature_index, Feature* feature) {
+        FeatureHistory* history = feature->getHistory();
+        history->clear();
+        history->reserve(frameCount);
+        feature->setMin(minimums[feature_index]);
+        feature->setMax(maximums[feature_index]);
+
+        if (valueSize == 8)
+            history->addValues(getColumn(feature_index), frameCount);
+        else {
+            const float* column = (const float*)columns[feature_index];
+
+            for (int i = 0; i < frameCount; i++)
+                feature->addHistoryFrame(column[i]);
+        }
+    }
+
+    vector<Feature*> TrajectoryFile::createFeatures() {
+        vector<Feature*> features;
+
+        for (int i = 0; i < getFeatureCount(); i++) {
+            Feature* feature = new Feature();
+            loadFeature(i, feature);
+            features.push_back(feature);
+        }
+
+        return features;
+    }
+
+    /*----------*
+     * Writing. *
+     *----------*/
+
+    void TrajectoryFile::save(
+        string path,
+        vector<Feature*> features,
+        double sample_rate,
+        double hop_size,
+        int value_size,
+        int frame_count
+    ) {
+        if (frame_count < 0) {
+            frame_count = features.empty() ? 0 : features[0]->getHistorySize();
+
+            for (int i = 1; i < features.size(); i++)
+                frame_count = minimum(frame_count, features[i]->getHistorySize());
+        }
+
+        if (value_size != 4)
+            value_size = 8;
+
+        ofstream file(path.c_str(), ios::out | ios::binary);
+
+        if (!file.is_open())
+            throw TrajectoryFileException();
+
+        char header[header_size];
+        memset(header, 0, header_size);
+
+        uint32_t version = trajectory_version;
+        uint32_t feature_count = features.size();
+        uint32_t size = value_size;
+        uint64_t frames = frame_count;
+
+        memcpy(header, trajectory_magic, 8);
+        memcpy(header + 8, &version, 4);
+        memcpy(header + 12, &feature_count, 4);
+        memcpy(header + 16, &size, 4);
+        memcpy(header + 24, &frames, 8);
+        memcpy(header + 32, &sample_rate, 8);
+        memcpy(header + 40, &hop_size, 8);
+
+        file.write(header, header_size);
+
+        for (int i = 0; i < features.size(); i++) {
+            char entry[entry_size];
+            memset(entry, 0, entry_size);
+
+            double feature_min = features[i]->getMin();
+            double feature_max = features[i]->getMax();
+
+            strncpy(entry, features[i]->toString(), name_size - 1);
+            memcpy(entry + name_size, &feature_min, 8);
+            memcpy(entry + name_size + 8, &feature_max, 8);
+
+            file.write(entry, entry_size);
+        }
+
+        vector<float> single_column(frame_count);
+
+        for (int i = 0; i < features.size() && frame_count > 0; i++) {
+            const double* history = features[i]->getHistory()->getData();
+
+            if (value_size == 8)
+                file.write((const char*)history, frame_count * sizeof(double));
+            else {
+                for (int j = 0; j < frame_count; j++)
+                    single_column[j] = history[j];
+
+                file.write((const char*)&single_column[0], frame_count * sizeof(float));
+            }
+        }
+
+        if (!file.good())
+            throw TrajectoryFileException();
+    }
+
+    /*-----------------*
+     * CSV conversion. *
+     *-----------------*/
+
+    void TrajectoryFile::convertFromCSV(
+        string csv_path,
+        string path,
+        double sample_rate,
+        double hop_size,
+        int value_size
+    ) {
+        vector<vector<double> > values;
+
+        if (!read_csv_columns(csv_path, values))
+            throw TrajectoryFileException();
+
+        vector<Feature*> features;
+
+        for (int i = 0; i < values.size(); i++) {
+            Feature* feature = new Feature();
+            feature->getHistory()->addValues(&values[i][0], values[i].size());
+
+            features.push_back(feature);
+        }
+
+        save(path, features, sample_rate, hop_size, value_size);
+
+        for (int i = 0; i < features.size(); i++)
+            delete features[i];
+    }
+
+    void TrajectoryFile::saveCSV(string csv_path) {
+        vector<vector<double> > rows(frameCount, vector<double>(getFeatureCount()));
+        vector<double> column(frameCount);
+
+        for (int i = 0; i < getFeatureCount() && frameCount > 0; i++) {
+            readColumn(i, &column[0]);
+
+            for (int j = 0; j < frameCount; j++)
+                rows[j][i] = column[j];
+        }
+
+        write_csv_file(csv_path, rows);
+    }
+}
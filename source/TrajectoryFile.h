@@ -0,0 +1,141 @@
+/*
+    Copyright 2009 Arizona State University
+    
+    This file is part of Sirens.
+    
+    Sirens is free software: you can redistribute it and/or modify it under the
+    terms of the GNU Lesser General Public License as  published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+    
+    Sirens is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+    details.
+    
+    You should have received a copy of the GNU Lesser General Public License
+    along with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIRENS_TRAJECTORYFILE_H
+#define SIRENS_TRAJECTORYFILE_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "Feature.h"
+#include "Exceptions.h"
+
+/*
+    TrajectoryFile - binary, columnar storage for feature trajectories, so that
+        features extracted once can be segmented or compared later without
+        parsing text. Files are memory-mapped when opened, and columns are
+        copied straight into feature histories.
+
+    Layout (little-endian):
+        Header, 64 bytes.
+            char[8]   magic, "SIRENSTJ"
+            uint32    version (1)
+            uint32    feature count
+            uint32    value size (4 for float32, 8 for float64)
+            uint32    reserved
+            uint64    frame count
+            float64   sample rate (Hz)
+            float64   hop size (samples)
+            uint8[16] reserved
+        Feature table, 64 bytes per feature.
+            char[48]  name, NUL-padded
+            float64   normalization minimum
+            float64   normalization maximum
+        Columns, one per feature in table order, each frame count values.
+
+    The header and table sizes are multiples of 8 bytes, so float64 columns are
+    aligned in the mapping and can be read in place (see getColumn).
+*/
+
+namespace Sirens {
+    class TrajectoryFile {
+    private:
+        // Memory mapping of the open file.
+        char* mapping;
+        size_t mappingSize;
+
+        int valueSize;
+        int frameCount;
+        double sampleRate;
+        double hopSize;
+
+        vector<string> names;
+        vector<double> minimums;
+        vector<double> maximums;
+        vector<const char*> columns;
+
+        // Not copyable; the mapping is owned.
+        TrajectoryFile(const TrajectoryFile& other);
+        TrajectoryFile& operator=(const TrajectoryFile& other);
+
+    public:
+        TrajectoryFile();
+        ~TrajectoryFile();
+
+        // Reading. open throws TrajectoryFileException if path can't be read
+        // or isn't a trajectory file.
+        void open(string path);
+        void close();
+        bool isOpen();
+
+        // Whether path starts with the trajectory file magic.
+        static bool isTrajectoryFile(string path);
+
+        int getFeatureCount();
+        int getFrameCount();
+        int getValueSize();
+        double getSampleRate();
+        double getHopSize();
+
+        string getFeatureName(int feature);
+        double getMin(int feature);
+        double getMax(int feature);
+
+        // A float64 column, read in place and valid until close. NULL for
+        // float32 files; use readColumn instead.
+        const double* getColumn(int feature);
+
+        // Copies a column into values (frame count elements).
+        void readColumn(int feature, double* values);
+
+        // Replaces a feature's history with a column, and sets its
+        // normalization range.
+        void loadFeature(int feature_index, Feature* feature);
+
+        // New features (owned by the caller) holding every column.
+        vector<Feature*> createFeatures();
+
+        // Writing. Saves the first frame_count frames of each feature's
+        // history (all frames shared by every feature if -1).
+        static void save(
+            string path,
+            vector<Feature*> features,
+            double sample_rate,
+            double hop_size,
+            int value_size = 8,
+            int frame_count = -1
+        );
+
+        // Conversion to and from the CSV layout written by
+        // FeatureSet::saveCSV (one row per frame, one column per feature).
+        // Features converted from CSV are named "Feature".
+        static void convertFromCSV(
+            string csv_path,
+            string path,
+            double sample_rate = 0,
+            double hop_size = 0,
+            int value_size = 8
+        );
+
+        void saveCSV(string csv_path);
+    };
+}
+
+#endif
@@ -20,6 +20,8 @@
 #include "TransientIndex.h"
 
 #include "math_support.h"
+#include "TableCache.h"
+#include "SpectralStatistics.h"
 
 #include <cmath>
 using namespace std;
@@ -46,85 +48,75 @@ namespace Sirens {
         setMels(in_mels);
     }
     
+    TransientIndex::TransientIndex(
+        const TransientIndex& other
+    ) : Feature(other) {
+        spectrumSize = other.spectrumSize;
+        sampleRate = other.sampleRate;
+        filters = other.filters;
+        mels = other.mels;
+        
+        mfccOld = NULL;
+        mfccNew = NULL;
+        dctMatrix = NULL;
+        filterTemp = NULL;
+        filterBank = NULL;
+        
+        if (initialized)
+            initialize();
+    }
+    
     TransientIndex::~TransientIndex() {
         freeMemory();
     }
     
     void TransientIndex::freeMemory() {
-        if (dctMatrix)
-            delete dctMatrix;
+        TableCache::release(dctMatrix);
+        TableCache::release(filterBank);
         
-        if (filterBank)
-            delete filterBank;
-        
-        if (filterTemp)
-            delete filterTemp;
-        
-        if (mfccNew)
-            delete mfccNew;
+        dctMatrix = NULL;
+        filterBank = NULL;
         
-        if (mfccOld)
-            delete mfccOld;
+        freeBuffer(filterTemp);
+        freeBuffer(mfccNew);
+        freeBuffer(mfccOld);
     }
     
     void TransientIndex::initialize() { 
-        dctMatrix = new double[filters * mels];
-        filterBank = new double[filters * spectrumSize];
-        filterTemp = new double[filters];
+        dctMatrix = TableCache::acquireDCTMatrix(filters, mels);
+        filterBank = TableCache::acquireMelFilterBank(filters, spectrumSize, sampleRate);
         
-        mfccNew = new double[mels];
-        mfccOld = new double[mels];
+        createBuffers();
+    }
     
-        // Initialisation
-        double min_mel = hz_to_mel(50.0);
-        double max_mel = hz_to_mel(sampleRate / 2);
-        
-        double* filter_values = new double[spectrumSize];
-        double* filter_centers = new double[filters + 2];
-        
-        for (int i = 0; i < spectrumSize; i++)
-            filter_values[i] = double(sampleRate * i) / 
-                double(2 * (spectrumSize - 1));
+    void TransientIndex::createBuffers() {
+        filterTemp = createBuffer<double>(filters);
         
-        for (int i = 0; i < mels; i++) {
-            for (int j = 0; j < filters; j++) {
-                dctMatrix[i * filters + j] = cos(
-                    (i + 1) * (PI / filters * (j + 0.5))
-                );
-            }
-        }
-        
-        for (int i = 0; i < filters + 2; i++) {
-            filter_centers[i] = mel_to_hz(
-                min_mel + ((max_mel - min_mel) / (filters + 1)) * i
-            );
-        }
-
-        for (int i = 0; i < filters; i++) {
-            for (int j = 0; j < spectrumSize; j++) {
-                if (
-                    (filter_values[j] >= filter_centers[i]) && 
-                    (filter_values[j] < filter_centers[i + 1])
-                ) {
-                    filterBank[(i * spectrumSize) + j] = (
-                        filter_values[j] - filter_centers[i]
-                    ) / (
-                        filter_centers[i + 1] - filter_centers[i]
-                    );
-                } else if (
-                    (filter_values[j] >= filter_centers[i + 1]) && 
-                    (filter_values[j] < filter_centers[i + 2])
-                ) {
-                    filterBank[(i * spectrumSize) + j] = (
-                        filter_values[j] - filter_centers[i + 2]
-                    ) / (
-                        filter_centers[i + 1] - filter_centers[i + 2]
-                    );
-                } else
-                    filterBank[(i * spectrumSize) + j] = 0;
-            }
-        }
+        mfccNew = createBuffer<double>(mels);
+        mfccOld = createBuffer<double>(mels);
         
+        clearBuffers();
+    }
+    
+    void TransientIndex::resetState() {
+        // Uninitialized buffers are cleared when they are created.
+        if (initialized)
+            clearBuffers();
+    }
+    
+    // Only the previous frame's coefficients carry over; the other buffers
+    // are rewritten every frame.
+    void TransientIndex::saveRunningState(Checkpoint* checkpoint) {
+        checkpoint->writeInt(mels);
+        checkpoint->writeDoubles(mfccOld, mels);
+    }
+    
+    void TransientIndex::loadRunningState(Checkpoint* checkpoint) {
+        checkpoint->expectInt(mels);
+        checkpoint->readDoubles(mfccOld, mels);
+    }
+    
+    void TransientIndex::clearBuffers() {
         for (int i = 0; i < mels; i++) {
             mfccNew[i] = 0;
             mfccOld[i] = 0;
@@ -132,9 +124,6 @@ namespace Sirens {
         
         for (int i = 0; i < filters; i++)
             filterTemp[i] = 0;
-    
-        delete[] filter_values;
-        delete[] filter_centers;
     }
  
     void TransientIndex::setSpectrumSize(int spectrum_size) {
@@ -190,10 +179,35 @@ namespace Sirens {
                 filterTemp[i] += filterBank[(i * spectrum_size) + j] * (*input_item);
                 input_item ++;
             }
-            
-            filterTemp[i] = (filterTemp[i] > 0) ? log(filterTemp[i]) : 0;
         }
+        
+        calculateFromFilters();
+    }
     
+    bool TransientIndex::configureStatistics(SpectralStatistics* statistics) {
+        statistics->requestMelBands(spectrumSize, sampleRate, filters);
+        
+        return true;
+    }
+    
+    bool TransientIndex::performFusedCalculation(SpectralStatistics* statistics) {
+        if (!statistics->hasMelBands(spectrumSize, sampleRate, filters))
+            return false;
+        
+        double* mel_bands = statistics->getMelBands();
+        
+        for (int i = 0; i < filters; i++)
+            filterTemp[i] = mel_bands[i];
+        
+        calculateFromFilters();
+        
+        return true;
+    }
+    
+    void TransientIndex::calculateFromFilters() {
+        for (int i = 0; i < filters; i++)
+            filterTemp[i] = (filterTemp[i] > 0) ? log(filterTemp[i]) : 0;
+        
         for (int i = 0; i < mels; i++) {
             mfccNew[i] = 0;
         
@@ -27,24 +27,37 @@ namespace Sirens {
     private:
         double* mfccOld;
         double* mfccNew;
-        double* dctMatrix;
         double* filterTemp;
-        double* filterBank;
+        
+        // Shared tables from TableCache.
+        const double* dctMatrix;
+        const double* filterBank;
         
         int filters, mels, spectrumSize, sampleRate;
         
         void freeMemory();
         void initialize();
         
+        // Calculates the index from the mel filter energies in filterTemp.
+        void calculateFromFilters();
+        
+        // Allocates the per-frame buffers and clears the previous frame.
+        void createBuffers();
+        void clearBuffers();
+        virtual void resetState();
+        virtual void saveRunningState(Checkpoint* checkpoint);
+        virtual void loadRunningState(Checkpoint* checkpoint);
+        
     public:
         TransientIndex(
-            int history_size = 1, 
+            int history_size = 0, 
             int spectrum_size = 1024, 
             int sample_rate = 44100, 
             int in_filters = 30, 
             int in_mels = 15
         );
         
+        TransientIndex(const TransientIndex& other);
         ~TransientIndex();
         
         void setSpectrumSize(int spectrum_size);
@@ -59,6 +72,10 @@ namespace Sirens {
         
         virtual void performCalculation();
         virtual const char* toString();
+        virtual Feature* clone() {return new TransientIndex(*this);}
+        
+        virtual bool configureStatistics(SpectralStatistics* statistics);
+        virtual bool performFusedCalculation(SpectralStatistics* statistics);
     };
 }
 
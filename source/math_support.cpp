@@ -38,6 +38,14 @@ namespace Sirens {
         return a > b ? a : b;
     }
 
+    long minimum(long a, long b) {
+        return a < b ? a : b;
+    }
+
+    long maximum(long a, long b) {
+        return a > b ? a : b;
+    }
+
     double minimum(double a, double b) {
         return a < b ? a : b;
     }
@@ -99,6 +107,100 @@ namespace Sirens {
         return window;
     }
 
+    // Bark scale frequency of each bin.
+    double* create_bark_units(int spectrum_size, int sample_rate) {
+        double* bark_units = new double[spectrum_size];
+
+        for (int i = 0; i < spectrum_size; i++) {
+            bark_units[i] = hz_to_bark(
+                double(sample_rate * i) / double(2 * (spectrum_size - 1))
+            );
+        }
+
+        return bark_units;
+    }
+
+    // Bark bandwidth between consecutive bins (spectrum_size - 1 values).
+    double* create_bark_weights(double* bark_units, int spectrum_size) {
+        double* bark_weights = new double[spectrum_size - 1];
+
+        for (int i = 0; i < spectrum_size - 1; i++)
+            bark_weights[i] = bark_units[i + 1] - bark_units[i];
+
+        return bark_weights;
+    }
+
+    // Triangular mel filters from 50 Hz to Nyquist, stored row-major as
+    // filters x spectrum_size.
+    double* create_mel_filter_bank(
+        int filters,
+        int spectrum_size,
+        int sample_rate
+    ) {
+        double* filter_bank = new double[filters * spectrum_size];
+
+        double min_mel = hz_to_mel(50.0);
+        double max_mel = hz_to_mel(sample_rate / 2);
+
+        double* filter_values = new double[spectrum_size];
+        double* filter_centers = new double[filters + 2];
+
+        for (int i = 0; i < spectrum_size; i++)
+            filter_values[i] = double(sample_rate * i) /
+                double(2 * (spectrum_size - 1));
+
+        for (int i = 0; i < filters + 2; i++) {
+            filter_centers[i] = mel_to_hz(
+                min_mel + ((max_mel - min_mel) / (filters + 1)) * i
+            );
+        }
+
+        for (int i = 0; i < filters; i++) {
+            for (int j = 0; j < spectrum_size; j++) {
+                if (
+                    (filter_values[j] >= filter_centers[i]) &&
+                    (filter_values[j] < filter_centers[i + 1])
+                ) {
+                    filter_bank[(i * spectrum_size) + j] = (
+                        filter_values[j] - filter_centers[i]
+                    ) / (
+                        filter_centers[i + 1] - filter_centers[i]
+                    );
+                } else if (
+                    (filter_values[j] >= filter_centers[i + 1]) &&
+                    (filter_values[j] < filter_centers[i + 2])
+                ) {
+                    filter_bank[(i * spectrum_size) + j] = (
+                        filter_values[j] - filter_centers[i + 2]
+                    ) / (
+                        filter_centers[i + 1] - filter_centers[i + 2]
+                    );
+                } else
+                    filter_bank[(i * spectrum_size) + j] = 0;
+            }
+        }
+
+        delete [] filter_values;
+        delete [] filter_centers;
+
+        return filter_bank;
+    }
+
+    // DCT-II basis for the first mels cepstral coefficients, mels x filters.
+    double* create_dct_matrix(int filters, int mels) {
+        double* dct_matrix = new double[filters * mels];
+
+        for (int i = 0; i < mels; i++) {
+            for (int j = 0; j < filters; j++) {
+                dct_matrix[i * filters + j] = cos(
+                    (i + 1) * (PI / filters * (j + 0.5))
+                );
+            }
+        }
+
+        return dct_matrix;
+    }
+
     double lerp(double value, double min, double max) {
         return (value - min) / (max - min);
     }
@@ -33,6 +33,8 @@ namespace Sirens {
 
     int minimum(int a, int b);
     int maximum(int a, int b);
+    long minimum(long a, long b);
+    long maximum(long a, long b);
     double minimum(double a, double b);
     double maximum(double a, double b);
 
@@ -51,6 +53,16 @@ namespace Sirens {
     double mel_to_hz(double mel);
 
     double* create_hamming_window(int size);
+
+    // Perceptual lookup tables for a spectrum of spectrum_size bins.
+    double* create_bark_units(int spectrum_size, int sample_rate);
+    double* create_bark_weights(double* bark_units, int spectrum_size);
+    double* create_mel_filter_bank(
+        int filters,
+        int spectrum_size,
+        int sample_rate
+    );
+    double* create_dct_matrix(int filters, int mels);
 }
 
 #endif
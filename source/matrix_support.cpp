@@ -17,6 +17,10 @@
     along with Sirens. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
 #include <boost/numeric/ublas/triangular.hpp>
 #include <boost/numeric/ublas/lu.hpp>
 using namespace boost::numeric;
@@ -64,6 +68,45 @@ namespace Sirens {
         return det;
     }
 
+    bool solve_linear_system(double* a, double* b, int n) {
+        for (int column = 0; column < n; column++) {
+            int pivot = column;
+            
+            for (int row = column + 1; row < n; row++) {
+                if (fabs(a[row * n + column]) > fabs(a[pivot * n + column]))
+                    pivot = row;
+            }
+            
+            if (a[pivot * n + column] == 0)
+                return false;
+            
+            if (pivot != column) {
+                for (int i = 0; i < n; i++)
+                    swap(a[pivot * n + i], a[column * n + i]);
+                
+                swap(b[pivot], b[column]);
+            }
+            
+            for (int row = column + 1; row < n; row++) {
+                double factor = a[row * n + column] / a[column * n + column];
+                
+                for (int i = column; i < n; i++)
+                    a[row * n + i] -= factor * a[column * n + i];
+                
+                b[row] -= factor * b[column];
+            }
+        }
+        
+        for (int row = n - 1; row >= 0; row--) {
+            for (int i = row + 1; i < n; i++)
+                b[row] -= a[row * n + i] * b[i];
+            
+            b[row] /= a[row * n + row];
+        }
+        
+        return true;
+    }
+
     ublas::matrix<double> normalize_affinity(ublas::matrix<double> input) {
         ublas::vector<double> ones = ublas::scalar_vector<double>(
             input.size1(),
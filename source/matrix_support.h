@@ -20,13 +20,137 @@
 #ifndef SIRENS_MATRIX_SUPPORT_H
 #define SIRENS_MATRIX_SUPPORT_H
 
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
 #include <boost/numeric/ublas/matrix.hpp>
 using namespace boost::numeric;
 
+#include "FixedMatrix.h"
+
 namespace Sirens {
     ublas::matrix<double> invert(ublas::matrix<double> input);
     double determinant(ublas::matrix<double> input);
+    
+    // Solves the row-major n x n system a x = b in place (b becomes x) by
+    // Gaussian elimination with partial pivoting. Returns false if a is
+    // singular.
+    bool solve_linear_system(double* a, double* b, int n);
     ublas::matrix<double> normalize_affinity(ublas::matrix<double> input);
+    
+    /*----------------------*
+     * Fixed-size matrices. *
+     *----------------------*/
+    
+    // As with the ublas versions, invert returns a zero matrix if input is
+    // singular. 2x2 matrices use the closed forms.
+    inline double determinant(const Matrix2& input) {
+        return input(0, 0) * input(1, 1) - input(0, 1) * input(1, 0);
+    }
+    
+    inline Matrix2 invert(const Matrix2& input) {
+        Matrix2 inverse;
+        double det = determinant(input);
+        
+        if (det != 0) {
+            inverse(0, 0) = input(1, 1) / det;
+            inverse(0, 1) = -input(0, 1) / det;
+            inverse(1, 0) = -input(1, 0) / det;
+            inverse(1, 1) = input(0, 0) / det;
+        }
+        
+        return inverse;
+    }
+    
+    // Solves a x = b in place (b becomes x). Returns false if a is singular.
+    template <int Size>
+    inline bool solve(FixedMatrix<Size, Size> a, FixedVector<Size>& b) {
+        return solve_linear_system(&a.data[0][0], b.data, Size);
+    }
+    
+    template <int Size>
+    inline double determinant(FixedMatrix<Size, Size> input) {
+        double det = 1;
+        
+        for (int column = 0; column < Size; column++) {
+            int pivot = column;
+            
+            for (int row = column + 1; row < Size; row++) {
+                if (fabs(input(row, column)) > fabs(input(pivot, column)))
+                    pivot = row;
+            }
+            
+            if (input(pivot, column) == 0)
+                return 0;
+            
+            if (pivot != column) {
+                for (int i = 0; i < Size; i++)
+                    swap(input(pivot, i), input(column, i));
+                
+                det = -det;
+            }
+            
+            det *= input(column, column);
+            
+            for (int row = column + 1; row < Size; row++) {
+                double factor = input(row, column) / input(column, column);
+                
+                for (int i = column; i < Size; i++)
+                    input(row, i) -= factor * input(column, i);
+            }
+        }
+        
+        return det;
+    }
+    
+    template <int Size>
+    inline FixedMatrix<Size, Size> invert(const FixedMatrix<Size, Size>& input) {
+        FixedMatrix<Size, Size> inverse;
+        
+        for (int column = 0; column < Size; column++) {
+            FixedVector<Size> unit;
+            unit[column] = 1;
+            
+            if (!solve(input, unit))
+                return FixedMatrix<Size, Size>();
+            
+            for (int row = 0; row < Size; row++)
+                inverse(row, column) = unit[row];
+        }
+        
+        return inverse;
+    }
+    
+    // Copies the leading rows x columns block into a ublas matrix.
+    template <int Rows, int Columns>
+    inline ublas::matrix<double> to_ublas(
+        const FixedMatrix<Rows, Columns>& input, 
+        int rows = Rows, 
+        int columns = Columns
+    ) {
+        ublas::matrix<double> output(rows, columns);
+        
+        for (int row = 0; row < rows; row++) {
+            for (int column = 0; column < columns; column++)
+                output(row, column) = input(row, column);
+        }
+        
+        return output;
+    }
+    
+    template <int Size>
+    inline ublas::vector<double> to_ublas(
+        const FixedVector<Size>& input, 
+        int size = Size
+    ) {
+        ublas::vector<double> output(size);
+        
+        for (int i = 0; i < size; i++)
+            output[i] = input[i];
+        
+        return output;
+    }
 }
 
 #endif
@@ -20,95 +20,148 @@
 #include "savitzky_golay.h"
 
 namespace Sirens {
+    const double savitzky_golay_first[savitzky_golay_f] = {
+        0.0323312535450935,
+        0.00850822461712981,
+        -0.00829006501156256,
+        -0.0189798856843667,
+        -0.0244279796179967,
+        -0.0254515609024968,
+        -0.0228183155012423,
+        -0.0172464012509389,
+        -0.00940444786162312,
+        8.84430833381321e-05,
+        0.0106626981272472,
+        0.0217982719400757,
+        0.0330246473184647,
+        0.0439208351857245,
+        0.0541153745918351,
+        0.0632863327134455,
+        0.0711613048538743,
+        0.0775174144431092,
+        0.0821813130378076,
+        0.0850291803212959,
+        0.0859867241035703,
+        0.0850291803212959,
+        0.0821813130378076,
+        0.0775174144431092,
+        0.0711613048538743,
+        0.0632863327134455,
+        0.0541153745918351,
+        0.0439208351857245,
+        0.0330246473184647,
+        0.0217982719400757,
+        0.0106626981272472,
+        8.84430833381564e-05,
+        -0.00940444786162310,
+        -0.0172464012509389,
+        -0.0228183155012423,
+        -0.0254515609024968,
+        -0.0244279796179966,
+        -0.0189798856843667,
+        -0.00829006501156248,
+        0.00850822461712988,
+        0.0323312535450935
+    };
+
+    const double savitzky_golay_second[savitzky_golay_f] = {
+        0.00733573478893954,
+        0.00426393421288486,
+        0.00160828961169289,
+        -0.000653101960681753,
+        -0.00254214345028448,
+        -0.00408073780316071,
+        -0.00529078796535584,
+        -0.00619419688291528,
+        -0.00681286750188443,
+        -0.00716870276830871,
+        -0.00728360562823351,
+        -0.00717947902770424,
+        -0.00687822591276632,
+        -0.00640174922946515,
+        -0.00577195192384613,
+        -0.00501073694195466,
+        -0.00414000722983617,
+        -0.00318166573353605,
+        -0.00215761539909971,
+        -0.00108975917257256,
+        -4.35165292826184e-19,
+        0.00108975917257256,
+        0.00215761539909971,
+        0.00318166573353605,
+        0.00414000722983617,
+        0.00501073694195467,
+        0.00577195192384613,
+        0.00640174922946515,
+        0.00687822591276632,
+        0.00717947902770425,
+        0.00728360562823351,
+        0.00716870276830871,
+        0.00681286750188444,
+        0.00619419688291529,
+        0.00529078796535585,
+        0.00408073780316072,
+        0.00254214345028449,
+        0.000653101960681753,
+        -0.00160828961169289,
+        -0.00426393421288486,
+        -0.00733573478893955
+    };
+
     void fill_savitzky_golay(
         ublas::vector<double>& first,
         ublas::vector<double>& second
     ) {
-        first.resize(41);
-        second.resize(41);
-
-        first[0] = 0.0323312535450935;
-        first[1] = 0.00850822461712981;
-        first[2] = -0.00829006501156256;
-        first[3] = -0.0189798856843667;
-        first[4] = -0.0244279796179967;
-        first[5] = -0.0254515609024968;
-        first[6] = -0.0228183155012423;
-        first[7] = -0.0172464012509389;
-        first[8] = -0.00940444786162312;
-        first[9] = 8.84430833381321e-05;
-        first[10] = 0.0106626981272472;
-        first[11] = 0.0217982719400757;
-        first[12] = 0.0330246473184647;
-        first[13] = 0.0439208351857245;
-        first[14] = 0.0541153745918351;
-        first[15] = 0.0632863327134455;
-        first[16] = 0.0711613048538743;
-        first[17] = 0.0775174144431092;
-        first[18] = 0.0821813130378076;
-        first[19] = 0.0850291803212959;
-        first[20] = 0.0859867241035703;
-        first[21] = 0.0850291803212959;
-        first[22] = 0.0821813130378076;
-        first[23] = 0.0775174144431092;
-        first[24] = 0.0711613048538743;
-        first[25] = 0.0632863327134455;
-        first[26] = 0.0541153745918351;
-        first[27] = 0.0439208351857245;
-        first[28] = 0.0330246473184647;
-        first[29] = 0.0217982719400757;
-        first[30] = 0.0106626981272472;
-        first[31] = 8.84430833381564e-05;
-        first[32] = -0.00940444786162310;
-        first[33] = -0.0172464012509389;
-        first[34] = -0.0228183155012423;
-        first[35] = -0.0254515609024968;
-        first[36] = -0.0244279796179966;
-        first[37] = -0.0189798856843667;
-        first[38] = -0.00829006501156248;
-        first[39] = 0.00850822461712988;
-        first[40] = 0.0323312535450935;
-
-        second[0] = 0.00733573478893954;
-        second[1] = 0.00426393421288486;
-        second[2] = 0.00160828961169289;
-        second[3] = -0.000653101960681753;
-        second[4] = -0.00254214345028448;
-        second[5] = -0.00408073780316071;
-        second[6] = -0.00529078796535584;
-        second[7] = -0.00619419688291528;
-        second[8] = -0.00681286750188443;
-        second[9] = -0.00716870276830871;
-        second[10] = -0.00728360562823351;
-        second[11] = -0.00717947902770424;
-        second[12] = -0.00687822591276632;
-        second[13] = -0.00640174922946515;
-        second[14] = -0.00577195192384613;
-        second[15] = -0.00501073694195466;
-        second[16] = -0.00414000722983617;
-        second[17] = -0.00318166573353605;
-        second[18] = -0.00215761539909971;
-        second[19] = -0.00108975917257256;
-        second[20] = -4.35165292826184e-19;
-        second[21] = 0.00108975917257256;
-        second[22] = 0.00215761539909971;
-        second[23] = 0.00318166573353605;
-        second[24] = 0.00414000722983617;
-        second[25] = 0.00501073694195467;
-        second[26] = 0.00577195192384613;
-        second[27] = 0.00640174922946515;
-        second[28] = 0.00687822591276632;
-        second[29] = 0.00717947902770425;
-        second[30] = 0.00728360562823351;
-        second[31] = 0.00716870276830871;
-        second[32] = 0.00681286750188444;
-        second[33] = 0.00619419688291529;
-        second[34] = 0.00529078796535585;
-        second[35] = 0.00408073780316072;
-        second[36] = 0.00254214345028449;
-        second[37] = 0.000653101960681753;
-        second[38] = -0.00160828961169289;
-        second[39] = -0.00426393421288486;
-        second[40] = -0.00733573478893955;
+        first.resize(savitzky_golay_f);
+        second.resize(savitzky_golay_f);
+
+        for (int i = 0; i < savitzky_golay_f; i++) {
+            first[i] = savitzky_golay_first[i];
+            second[i] = savitzky_golay_second[i];
+        }
+    }
+
+    void savitzky_golay_smooth(
+        const double* values,
+        int size,
+        int begin,
+        int end,
+        double* positions,
+        double* velocities
+    ) {
+        int padding = (savitzky_golay_f + 1) / 2;
+
+        for (int i = begin; i < end; i++) {
+            int first_value = i - padding;
+            double position = 0;
+            double velocity = 0;
+
+            if (first_value >= 0 && first_value + savitzky_golay_f <= size) {
+                const double* window = values + first_value;
+
+                for (int j = 0; j < savitzky_golay_f; j++) {
+                    position += savitzky_golay_first[j] * window[j];
+                    velocity += savitzky_golay_second[j] * window[j];
+                }
+            } else {
+                // Near either end.
+                for (int j = 0; j < savitzky_golay_f; j++) {
+                    int offset = first_value + j;
+
+                    if (offset < 0)
+                        offset = 0;
+                    else if (offset > size - 1)
+                        offset = size - 1;
+
+                    double value = values[offset];
+
+                    position += savitzky_golay_first[j] * value;
+                    velocity += savitzky_golay_second[j] * value;
+                }
+            }
+
+            positions[i - begin] = position;
+            velocities[i - begin] = velocity;
+        }
     }
 }
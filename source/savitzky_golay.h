@@ -30,10 +30,29 @@ namespace Sirens {
     static const int savitzky_golay_k = 4;
     static const int savitzky_golay_f = 41;
 
+    extern const double savitzky_golay_first[savitzky_golay_f];
+    extern const double savitzky_golay_second[savitzky_golay_f];
+
     void fill_savitzky_golay(
         ublas::vector<double>& first,
         ublas::vector<double>& second
     );
+
+    // Smoothed position (first filter) and velocity (second filter) of frames
+    // [begin, end) of the size values, written to positions[0] and
+    // velocities[0] onwards. Frame i is centered on value i - 1, and values
+    // before the first or after the last repeat the end values. Frame i reads
+    // no value past i + savitzky_golay_f / 2 - 1, so a streaming caller can
+    // smooth it (with the same result as over the whole trajectory) once that
+    // value has arrived.
+    void savitzky_golay_smooth(
+        const double* values,
+        int size,
+        int begin,
+        int end,
+        double* positions,
+        double* velocities
+    );
 }
 
 #endif
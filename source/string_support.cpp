@@ -20,8 +20,16 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 using namespace std;
 
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "string_support.h"
 
 namespace Sirens {
@@ -70,6 +78,245 @@ namespace Sirens {
         return ss.str();
     }
 
+    // Powers of ten that are exactly representable as doubles.
+    static const double exact_powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    static inline bool is_digit(char c) {
+        return (unsigned char)(c - '0') < 10;
+    }
+
+    double parse_double(const char* begin, const char* end, const char** next) {
+        const char* position = begin;
+        bool negative = false;
+
+        if (position < end && (*position == '-' || *position == '+')) {
+            negative = (*position == '-');
+            position++;
+        }
+
+        // Accumulate up to 19 significant digits. Past that the mantissa is
+        // too large for the exact path anyway, so further digits only matter
+        // to strtod.
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool found_digits = false;
+
+        for (; position < end && is_digit(*position); position++) {
+            found_digits = true;
+
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*position - '0');
+                digits += (mantissa > 0);
+            } else
+                exponent++;
+        }
+
+        if (position < end && *position == '.') {
+            position++;
+
+            for (; position < end && is_digit(*position); position++) {
+                found_digits = true;
+
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + (*position - '0');
+                    digits += (mantissa > 0);
+                    exponent--;
+                }
+            }
+        }
+
+        if (!found_digits) {
+            *next = begin;
+            return 0;
+        }
+
+        // An exponent is only consumed if it has at least one digit.
+        if (position < end && (*position == 'e' || *position == 'E')) {
+            const char* marker = position + 1;
+            bool negative_exponent = false;
+
+            if (marker < end && (*marker == '-' || *marker == '+')) {
+                negative_exponent = (*marker == '-');
+                marker++;
+            }
+
+            if (marker < end && is_digit(*marker)) {
+                int value = 0;
+
+                for (; marker < end && is_digit(*marker); marker++) {
+                    if (value < 100000)
+                        value = value * 10 + (*marker - '0');
+                }
+
+                exponent += negative_exponent ? -value : value;
+                position = marker;
+            }
+        }
+
+        *next = position;
+
+        if (mantissa == 0)
+            return negative ? -0.0 : 0.0;
+
+        // Both the mantissa and the power of ten are exact, so a single
+        // multiplication or division gives the correctly rounded result.
+        if (mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+            double value = double(mantissa);
+
+            if (exponent < 0)
+                value /= exact_powers_of_ten[-exponent];
+            else
+                value *= exact_powers_of_ten[exponent];
+
+            return negative ? -value : value;
+        }
+
+        string token(begin, position);
+        return strtod(token.c_str(), NULL);
+    }
+
+    static bool read_csv(
+        string path,
+        vector<vector<double> >& output,
+        const string& delimiters,
+        bool by_column
+    ) {
+        int file = open(path.c_str(), O_RDONLY);
+
+        if (file < 0)
+            return false;
+
+        struct stat status;
+
+        if (fstat(file, &status) != 0) {
+            close(file);
+            return false;
+        }
+
+        size_t size = status.st_size;
+
+        if (size == 0) {
+            close(file);
+            return true;
+        }
+
+        void* address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+        if (address == MAP_FAILED) {
+            close(file);
+            return false;
+        }
+
+        madvise(address, size, MADV_SEQUENTIAL);
+
+        bool is_delimiter[256];
+
+        for (int i = 0; i < 256; i++)
+            is_delimiter[i] = false;
+
+        for (int i = 0; i < delimiters.size(); i++)
+            is_delimiter[(unsigned char)delimiters[i]] = true;
+
+        const char* position = (const char*)address;
+        const char* end = position + size;
+        int first_column = output.size();
+        int columns = 0;
+        vector<double> row;
+
+        while (position < end) {
+            const char* line_end = (const char*)memchr(position, '\n', end - position);
+            const char* next_line = line_end ? line_end + 1 : end;
+
+            if (!line_end)
+                line_end = end;
+
+            if (line_end > position && *(line_end - 1) == '\r')
+                line_end--;
+
+            // Columns are pushed to directly once the first row has set their
+            // number; until then, and for row output, fields go through row.
+            bool direct = by_column && columns > 0;
+            int field = 0;
+            row.clear();
+
+            while (true) {
+                while (position < line_end && is_delimiter[(unsigned char)*position])
+                    position++;
+
+                if (position >= line_end)
+                    break;
+
+                const char* number_end;
+                double value = parse_double(position, line_end, &number_end);
+
+                // Anything between the number and the next delimiter is part
+                // of the same field and ignored.
+                position = number_end;
+
+                while (position < line_end && !is_delimiter[(unsigned char)*position])
+                    position++;
+
+                if (!direct)
+                    row.push_back(value);
+                else if (field < columns)
+                    output[first_column + field].push_back(value);
+
+                field++;
+            }
+
+            if (!row.empty()) {
+                if (!by_column)
+                    output.push_back(row);
+                else {
+                    // Reserve for the rest of the file from its line count.
+                    size_t rows = 1;
+
+                    for (
+                        const char* c = next_line;
+                        c < end && (c = (const char*)memchr(c, '\n', end - c));
+                        c++
+                    )
+                        rows++;
+
+                    columns = row.size();
+                    output.resize(first_column + columns);
+
+                    for (int i = 0; i < columns; i++) {
+                        output[first_column + i].reserve(rows);
+                        output[first_column + i].push_back(row[i]);
+                    }
+                }
+            }
+
+            position = next_line;
+        }
+
+        munmap(address, size);
+        close(file);
+
+        return true;
+    }
+
+    bool read_csv_columns(
+        string path,
+        vector<vector<double> >& columns,
+        const string& delimiters
+    ) {
+        return read_csv(path, columns, delimiters, true);
+    }
+
+    bool read_csv_rows(
+        string path,
+        vector<vector<double> >& rows,
+        const string& delimiters
+    ) {
+        return read_csv(path, rows, delimiters, false);
+    }
+
     void write_csv_file(string path, vector<vector<double> > input) {
         fstream file(path.c_str(), ios::out);
 
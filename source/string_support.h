@@ -39,6 +39,32 @@ namespace Sirens {
     double string_to_double(const std::string& s);
     string int_to_string(int data);
 
+    // Parses a number starting at begin, reading no further than end. next is
+    // set to the first character after the number, or to begin if there is
+    // none (in which case 0 is returned). Numbers with up to 15 significant
+    // digits and a decimal exponent within 22 are converted exactly without
+    // strtod; anything else falls back to it.
+    double parse_double(const char* begin, const char* end, const char** next);
+
+    // Numeric CSV input. The file is memory-mapped and scanned in place, so no
+    // line or token strings are built. Fields are separated by any of the
+    // delimiters and rows by newlines; fields that aren't numbers read as 0.
+    // read_csv_columns appends one column per field of the first non-empty
+    // row and fills it from every row (extra fields in later rows are
+    // ignored). read_csv_rows appends one vector per non-empty row.
+    // Both return false if the file can't be opened.
+    bool read_csv_columns(
+        string path,
+        vector<vector<double> >& columns,
+        const string& delimiters = ", "
+    );
+
+    bool read_csv_rows(
+        string path,
+        vector<vector<double> >& rows,
+        const string& delimiters = ", "
+    );
+
     // Vectors.
     void write_csv_file(
         string path,